@@ -175,7 +175,10 @@ CPU_INT08U FlushFile( CPU_INT08U fileID)
 
      // erase flash memory except for block 0
      if (Status_RemoteFlashBlock == 0)
+     {
         Status_RemoteFlashBlock = 0xFFFE; // initialize memory 
+        MarkTPDOChanged(&Status_RemoteFlashBlock, sizeof(Status_RemoteFlashBlock));
+     }
     
   }
   //note the erase won't complete until runcanserver completes, but dont delay here because then radio task can't monitor completion
@@ -251,6 +254,33 @@ CPU_INT08U ReadFileExternal( PACKET_HEADER * txPkt, CPU_INT08U * rxBuffer, CPU_I
 }
 
 
+/*
+*********************************************************************************************************
+*                                             ReadFileFragment( fileID, address, data, len )
+*
+* Description : reads one fragment of a windowed file upload (see PKT_FILE_WINDOW_READ in gateway.h)
+*
+* Argument(s) : File ID, address within the file, destination, length
+*
+* Return(s)   : status = 0 for success, 1 for a bad file ID.
+*
+*********************************************************************************************************
+*/  
+CPU_INT08U ReadFileFragment( CPU_INT08U fileID, CPU_INT32U address, CPU_INT08U * data, CPU_INT08U len )
+{
+  CPU_INT08U status;
+  OS_ERR err;
+  CPU_TS ts;
+  
+  if (fileID == 0 || fileID > MAX_NUM_FILES) 
+    return 1;
+  
+  OSMutexPend(&FileOpInterlock, 0, OS_OPT_PEND_BLOCKING, &ts, &err);
+  status = ReadRemoteFlash( baseAddress[fileID - 1] + address, data, len );
+  OSMutexPost(&FileOpInterlock, OS_OPT_POST_1, &err);
+  return status;
+}
+
 /*
 *********************************************************************************************************
 *                                                WriteRecordToFile ()
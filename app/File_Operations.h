@@ -118,6 +118,7 @@ CPU_INT08U WriteRecordToFile ( PACKET_HEADER * pkt );
 
 CPU_INT08U FlushFile( CPU_INT08U fileID);
 CPU_INT08U ReadFileExternal( PACKET_HEADER * txPkt, CPU_INT08U * rxBuffer, CPU_INT08U * len );
+CPU_INT08U ReadFileFragment( CPU_INT08U fileID, CPU_INT32U address, CPU_INT08U * data, CPU_INT08U len );
 CPU_INT08U WriteFileExternal( PACKET_HEADER * txPkt, CPU_INT08U * rxBuffer, CPU_INT08U * rxLen );
 CPU_INT08U InitFiles(CPU_INT08U reset);
 void BlankCheckRemoteFlash();
@@ -36,6 +36,9 @@
 
 
 #define SCRIPT_STACK_BYTES 200
+
+#define SCRIPT_MAILBOX_COUNT 8   //shared mailboxes for OPCODE_MBXPUT/MBXGET/MBXSEQ
+#define SCRIPT_MAILBOX_BYTES 16  //largest value or array that can be published
 /******************************************************************************************************
 *                                         Local Prototypes
 *******************************************************************************************************/
@@ -58,6 +61,18 @@ CPU_INT32U getElementAsUint32(CPU_INT08S opSignedType, CPU_INT32U opVar, CPU_INT
 *                                         Globals
 ********************************************************************************************************/
 CPU_INT08U currentScriptDebug = 0;
+
+//Mailboxes shared by all scripts and both lanes. sequence is incremented on every publish (0 = never published).
+//All access is inside a critical section so a consumer never sees a partly written value.
+typedef struct
+{
+  CPU_INT16U sequence;
+  CPU_INT08U elementSize; //bytes per element of the published value
+  CPU_INT08U length;      //bytes used in data
+  CPU_INT08U data[SCRIPT_MAILBOX_BYTES];
+} SCRIPT_MAILBOX;
+
+static SCRIPT_MAILBOX scriptMailbox[SCRIPT_MAILBOX_COUNT];
 //0 null
 //1 bool
 //2 uint8
@@ -167,7 +182,10 @@ CPU_INT08U currentScriptDebug = 0;
 
 //75-79 used for saturate 
 //80-81 used for 0 and CR CATMOV
-//82-90 available
+#define OPCODE_MBXPUT     82      //publish value to shared mailbox
+#define OPCODE_MBXGET     83      //consume value from shared mailbox
+#define OPCODE_MBXSEQ     84      //sequence number of shared mailbox
+//85-87 available
 #define OPCODE_BITCPY     88
 #define OPCODE_FILE_CLOSE 89
 #define OPCODE_STARTSCPT  90      //
@@ -2350,17 +2368,11 @@ CPU_INT08U RunScriptInterpreter( CPU_INT08U scriptPointer, CPU_INT08U *pChildScr
       }
     case OPCODE_RUNNEXT: // run next
       {              
-        CPU_INT08U pControlWord[4];
-        CPU_INT32U varsizeS = 0;
-        CPU_INT32U abortCodeS = 0;
-        UNS8 typeS = 0;
-        
         if(operandVar[0]>MAX_NUMBER_SCRIPTS)
           return SCRIPT_ERR_INVALID_CHILD_SCRIPT;
         
         *pChildScriptPointer = (CPU_INT08U) operandVar[0];  // set script number 
-        abortCodeS = readLocalDict( &ObjDict_Data, 0x1F51, *pChildScriptPointer, &pControlWord[0], &varsizeS, &typeS, 0);
-        if (abortCodeS != 0 || pControlWord[1] == 0)
+        if (*pChildScriptPointer == 0 || !(scriptLoadedBitmap & SCRIPT_BIT(*pChildScriptPointer)))
         {
           *pChildScriptPointer = 0;
           return SCRIPT_ERR_INVALID_CHILD_SCRIPT;
@@ -2617,6 +2629,101 @@ CPU_INT08U RunScriptInterpreter( CPU_INT08U scriptPointer, CPU_INT08U *pChildScr
         resultVarSize = numElements*bytesPerElement;
         break;
      }
+    case OPCODE_MBXPUT:
+      {
+        // operandVar[0]: mailbox number
+        // operandVar[1]: value - scalar, array, bytearray or string
+        // resultOperand (optional): new sequence number
+        CPU_INT08U elementSize;
+        CPU_SR_ALLOC();
+        
+        if (operandPointerType[0] != 0)
+          return SCRIPT_ERR_OPERAND_TYPE;  //mailbox number must be scalar
+        if (operandVar[0] >= SCRIPT_MAILBOX_COUNT)
+          return SCRIPT_ERR_OPERAND_OUT_OF_RANGE;
+        if (operandVarSize[1] > SCRIPT_MAILBOX_BYTES)
+          return SCRIPT_ERR_DESTINATIONARRAY;
+        
+        if (operandPointerType[1] == 0)
+          elementSize = operandVarSize[1];
+        else if (operandSignedType[1])
+          elementSize = abs(operandSignedType[1]);
+        else
+          elementSize = 1;  //string or bytearray
+        
+        CPU_CRITICAL_ENTER();
+        SCRIPT_MAILBOX *pMailbox = &scriptMailbox[operandVar[0]];
+        if (operandPointerType[1] == 0)
+          memcpy(pMailbox->data, &operandVar[1], operandVarSize[1]);  //little endian scalar
+        else
+          memcpy(pMailbox->data, (CPU_INT08U*)operandVar[1], operandVarSize[1]);
+        pMailbox->elementSize = elementSize;
+        pMailbox->length = operandVarSize[1];
+        if (++pMailbox->sequence == 0)
+          pMailbox->sequence = 1;
+        resultVar = pMailbox->sequence;
+        CPU_CRITICAL_EXIT();
+        break;
+      }
+    case OPCODE_MBXGET:
+      {
+        // operandVar[0]: mailbox number
+        // operandVar[1]: destination - stack or global array, bytearray or string. Element size must match 
+        //                the published value; bytes beyond the published length are unchanged
+        // resultOperand: sequence number of the value copied (0 if never published, destination unchanged)
+        // Copying the value and reading its sequence number in one opcode lets a consumer skip values it has 
+        // already seen even if the producer runs in the other lane.
+        CPU_INT08U elementSize;
+        CPU_INT32U dest = operandVar[1];
+        CPU_SR_ALLOC();
+        
+        if (operandPointerType[0] != 0 || operandPointerType[1] == 0)
+          return SCRIPT_ERR_OPERAND_TYPE;  //mailbox number must be scalar, destination must be pointer
+        if (operandVar[0] >= SCRIPT_MAILBOX_COUNT)
+          return SCRIPT_ERR_OPERAND_OUT_OF_RANGE;
+        
+        //destination must be writable: stack or global variables
+        if (!((dest >= stackVarTableAddress && dest + operandVarSize[1] <= stackVarTableAddress + SCRIPT_STACK_BYTES) ||
+              (dest >= (CPU_INT32U)globalVariables && dest + operandVarSize[1] <= (CPU_INT32U)&globalVariables[GLOBAL_VAR_TABLE_SIZE])))
+          return SCRIPT_ERR_DESTINATIONARRAY;
+        
+        if (operandSignedType[1])
+          elementSize = abs(operandSignedType[1]);
+        else
+          elementSize = 1;  //string or bytearray
+        
+        CPU_CRITICAL_ENTER();
+        SCRIPT_MAILBOX *pMailbox = &scriptMailbox[operandVar[0]];
+        if (pMailbox->sequence != 0)
+        {
+          if (pMailbox->elementSize != elementSize)
+          {
+            CPU_CRITICAL_EXIT();
+            return SCRIPT_ERR_OPERAND_TYPE_MISMATCH;
+          }
+          if (pMailbox->length > operandVarSize[1])
+          {
+            CPU_CRITICAL_EXIT();
+            return SCRIPT_ERR_DESTINATIONARRAY;
+          }
+          memcpy((CPU_INT08U*)dest, pMailbox->data, pMailbox->length);
+        }
+        resultVar = pMailbox->sequence;
+        CPU_CRITICAL_EXIT();
+        break;
+      }
+    case OPCODE_MBXSEQ:
+      {
+        // operandVar[0]: mailbox number
+        // resultOperand: current sequence number (0 if never published)
+        if (operandPointerType[0] != 0)
+          return SCRIPT_ERR_OPERAND_TYPE;
+        if (operandVar[0] >= SCRIPT_MAILBOX_COUNT)
+          return SCRIPT_ERR_OPERAND_OUT_OF_RANGE;
+        
+        resultVar = scriptMailbox[operandVar[0]].sequence;
+        break;
+      }
     case OPCODE_VECMAX:  
     case OPCODE_VECMAXI: 
      {
@@ -3699,7 +3806,9 @@ CPU_INT08U getNetworkOperand(CPU_INT08U opScopeType, CPU_INT08U *netAddress, CPU
   CPU_INT32U sizeLocal = 0;
   //JML: the network data must be declared static in in order to allocate the space.  
   //Otherwise, when assigning a pointer to it, the data may be overwritten before it is copied.
-  static CPU_INT08U data[MAX_GTWY_PKT_DATA] = {0};
+  //One buffer per script lane, so a preempting control lane script cannot overwrite background lane data.
+  static CPU_INT08U laneData[NUMBER_SCRIPT_LANES][MAX_GTWY_PKT_DATA] = {0};
+  CPU_INT08U *data = laneData[ScriptLane_Current()];
   
   // define PKT header
   PACKET_HEADER  pkt;
@@ -3723,7 +3832,10 @@ CPU_INT08U getNetworkOperand(CPU_INT08U opScopeType, CPU_INT08U *netAddress, CPU
     {
       if(numSubIndices > 1)
       {
-        GetBlockOD (&pkt, data, &size);
+        if(GetBlockOD (&pkt, data, &size) != 1)
+        {
+          abortCode = 6; //data holds the abort code and failing subindex
+        }
       }
       else
       {
@@ -3749,8 +3861,6 @@ CPU_INT08U getNetworkOperand(CPU_INT08U opScopeType, CPU_INT08U *netAddress, CPU
         pkt.protoCtrl = 0x24; //SDO read
       }
       
-      WaitUntilCANGatewayAvailable();
-      
       if(runCANGateway(&pkt, data, &size))
       {
         //error response
@@ -3760,8 +3870,6 @@ CPU_INT08U getNetworkOperand(CPU_INT08U opScopeType, CPU_INT08U *netAddress, CPU
       {       
         abortCode = 0;
       }
-  
-      MakeCANGatewayAvailable();    
     }
   }
   
@@ -3928,8 +4036,6 @@ CPU_INT08U setNetworkOperand(CPU_INT08U opScopeType, CPU_INT08U *netAddress, CPU
         pkt->protoCtrl = 0xA4; //SDO write
       }
       
-      WaitUntilCANGatewayAvailable();
-      
       if(runCANGateway(pkt, data, &rxLen)) // data and rxLen contain response and are unused below.  
       {
         abortCode = 6;
@@ -3938,8 +4044,6 @@ CPU_INT08U setNetworkOperand(CPU_INT08U opScopeType, CPU_INT08U *netAddress, CPU
       {       
         abortCode = 0;
       }
-      
-      MakeCANGatewayAvailable();
     }
   }
     
@@ -4174,24 +4278,12 @@ CPU_INT32U FindScriptAddress( CPU_INT08U scriptPointer )
 */
 UNS8 FindScriptPointer( UNS8 scriptID )
 {
-  UNS8 subIndexSize = 0;
   int i;
-  UNS8 type = 0;
-  UNS32 varsize = 0;
-  UNS8 pControlWord[4];
- 
-  readLocalDict( &ObjDict_Data, 0x1F51, 0, &subIndexSize, &varsize, &type, 0);
   
-  for (i = 1; i <= subIndexSize; i++)
+  for (i = 1; i <= MAX_NUMBER_SCRIPTS; i++)
   {
-    type = 0;
-    varsize = 0;        
-    
-    // set up control information
-    readLocalDict( &ObjDict_Data, 0x1F51, i, &pControlWord[0], &varsize, &type, 0);
-    
-    // test for match
-    if ( pControlWord[1] == scriptID)
+    // test for match against the RAM copy of the control word (script ID in bits 8-15)
+    if ( (UNS8)(scriptControlWord[i] >> 8) == scriptID)
     {
       return i;
     }      
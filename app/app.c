@@ -100,8 +100,16 @@ static  CPU_STK     RunIOScanTaskStk[RUNIOSCAN_STK_SIZE];
 static  OS_TCB      RunScriptTCB;
 static  CPU_STK     RunScriptTaskStk[RUNSCRIPT_STK_SIZE];
 
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+static  OS_TCB      RunScriptBackgroundTCB;
+static  CPU_STK     RunScriptBackgroundTaskStk[RUNSCRIPT_BG_STK_SIZE];
+#endif
+
 OS_SEM GatewaySem;
-OS_Q ScriptScheduler_Q;
+OS_SEM ScriptScheduler_Sem;
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+OS_SEM ScriptSchedulerBackground_Sem;
+#endif
 
 
 /*
@@ -259,14 +267,21 @@ static  void  App_TaskCreate (void)
   
   OSSemCreate(&GatewaySem, "CAN Gateway Semaphore", 0, &err); 
   if (err != OS_ERR_NONE) { while(1){asm("nop");}}
-  OSSemCreate(&GatewayAccessControl,  "CAN Gateway Access Control",  1,  &err); 
+  OSMutexCreate(&GatewayAccessControl,  "CAN Gateway Access Control",  &err); //mutex: RM bootloader protocol
   if (err != OS_ERR_NONE) { while(1){asm("nop");}}
+  InitCANGateway(); //SDO request contexts
   OSSemCreate(&CanTimerSem, "CANopen Alarms", 0, &err);
   if (err != OS_ERR_NONE) { while(1){asm("nop");}}
+  OSSemCreate(&CanRxSem, "CAN Receive", 0, &err);
+  if (err != OS_ERR_NONE) { while(1){asm("nop");}}
   OSSemCreate(&SleepSem, "Sleep Event", 0, &err);
   if (err != OS_ERR_NONE) { while(1){asm("nop");}}
-  OSQCreate(&ScriptScheduler_Q, "Script Q", MAX_QUEUED_SCRIPTS, &err);
+  OSSemCreate(&ScriptScheduler_Sem, "Script Scheduler", 0, &err);
   if (err != OS_ERR_NONE) { while(1){asm("nop");}}
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+  OSSemCreate(&ScriptSchedulerBackground_Sem, "Script Background Scheduler", 0, &err);
+  if (err != OS_ERR_NONE) { while(1){asm("nop");}}
+#endif
     
   
   
@@ -341,6 +356,22 @@ static  void  App_TaskCreate (void)
                  (OS_OPT      )(OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
                  (OS_ERR     *)&err);
   
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+  OSTaskCreate((OS_TCB    *)&RunScriptBackgroundTCB,                                           
+                 (CPU_CHAR   *)"RunScriptBackgroundTask",
+                 (OS_TASK_PTR )RunScriptBackgroundTask, 
+                 (void       *)0,
+                 (OS_PRIO     )RUNSCRIPT_BG_TASK_PRIO,
+                 (CPU_STK    *)&RunScriptBackgroundTaskStk[0],
+                 (CPU_STK_SIZE)RUNSCRIPT_BG_STK_SIZE / 10,
+                 (CPU_STK_SIZE)RUNSCRIPT_BG_STK_SIZE,
+                 (OS_MSG_QTY  )0,
+                 (OS_TICK     )0,
+                 (void       *)0,
+                 (OS_OPT      )(OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
+                 (OS_ERR     *)&err);
+#endif
+  
   
   Scripts_Init(); //only init scripts after semaphore has been created
   InitFiles(1); // do a full file reset only if no directory present
@@ -393,6 +424,9 @@ void setTaskStackUsage(void)
   StackIOScan = (UNS8)((RunIOScanTaskTCB.StkUsed*100)/RunIOScanTaskTCB.StkSize);
   StackSleep = (UNS8)((SleepTaskTCB.StkUsed*100)/SleepTaskTCB.StkSize);
   StackScript = (UNS8)((RunScriptTCB.StkUsed*100)/RunScriptTCB.StkSize);
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+  StackScriptBackground = (UNS8)((RunScriptBackgroundTCB.StkUsed*100)/RunScriptBackgroundTCB.StkSize);
+#endif
   //StackTick = (UNS8)((OSTickTaskTCB.StkUsed*100)/OSTickTaskTCB.StkSize); Tick Task removed in uC3.07
   StackIdle = (UNS8)((OSIdleTaskTCB.StkUsed*100)/OSIdleTaskTCB.StkSize);
   StackStats = (UNS8)((OSStatTaskTCB.StkUsed*100)/OSStatTaskTCB.StkSize);
@@ -57,7 +57,8 @@
 #define  SLEEP_PRIO                                    1  /* sleep event */
 #define  RUNIOSCAN_TASK_PRIO                           5  /* background I2C updates  */
 #define  APP_TASK_START_PRIO                           2  /* run gateway task  */
-#define  RUNSCRIPT_TASK_PRIO                           7  /* run script task - lower priority than tick task (6) */
+#define  RUNSCRIPT_TASK_PRIO                           7  /* run script task (control lane) - lower priority than tick task (6) */
+#define  RUNSCRIPT_BG_TASK_PRIO                        8  /* run script task (background lane) - preempted by the control lane */
                                   /* TICK_TASK PRIORITY =6 (See: os_cfg_app.h)*/
 #define  OS_TASK_TMR_PRIO                       (OS_CFG_PRIO_MAX - 2)
 
@@ -78,6 +79,7 @@
 //      SleepTaskTCB.StkUsed
 //      RunIOScanTaskTCB.StkUsed
 //      RunScriptTCB.StkUsed
+//      RunScriptBackgroundTCB.StkUsed
 //      OSIdleTaskTCB.StkUsed
 //      OSTickTaskTCB.StkUsed
 //      OSStatTaskTCB.StkUsed
@@ -90,6 +92,9 @@
 #define  RUNIOSCAN_STK_SIZE                             110 
 #define  APP_TASK_START_STK_SIZE                        500  
 #define  RUNSCRIPT_STK_SIZE                             500
+#define  RUNSCRIPT_BG_STK_SIZE          RUNSCRIPT_STK_SIZE  /* same interpreter frame as the control lane, check StackScriptBackground (0x3030.10) */
+#define  RUNSCRIPT_BG_LANE_EN                            0u  /* background lane task: RUNSCRIPT_BG_STK_SIZE words + TCB, more than the free RAM of the LPC2129.
+                                                                0: SCRIPT_CW_BACKGROUND_LANE is ignored, all scripts run in the control lane */
 
 
 ///*
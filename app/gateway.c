@@ -41,10 +41,9 @@ const CPU_INT08U CT_NODE_ADDRESS = 8;
 CO_Data * d  =  &ObjDict_Data;
 
 /* ----------------- APPLICATION GLOBALS ------------------ */
-OS_SEM GatewayAccessControl;
+OS_MUTEX GatewayAccessControl; //exclusive use of the CAN bus for the RM bootloader protocol (GatewaySem)
 
-
-static struct
+typedef struct
 {
 	enum 
 	{	
@@ -54,7 +53,10 @@ static struct
                 GW_SDO_BLOCK_UPLOAD,
 		GW_EXPECTING_SDO_UPLOAD_REPLY, 
 		GW_EXPECTING_SDO_DOWNLOAD_REPLY, 
-		GW_RECEIVED_REPLY
+		GW_RECEIVED_REPLY,
+		GW_FAST_UPLOAD_REPLY,    //expedited frames sent by the gateway, completed by completeCANGatewayFastSDO
+		GW_FAST_DOWNLOAD_REPLY,
+		GW_FAST_FALLBACK         //fast upload answered with a segmented transfer, redo through CanFestival
 	
 	} state;
 	CPU_INT16U index;
@@ -62,8 +64,98 @@ static struct
 	CPU_INT08U *txData, txDataLen;
 	CPU_INT08U *rxData, rxDataLen;
 	CPU_INT32U abortCode;
+        CPU_BOOLEAN inUse;
+        CPU_BOOLEAN fast;       //expedited fast path, no CanFestival SDO line
+        CPU_INT32U startTime;   //timer 1 count when the request was sent
+        enum
+        {
+                GW_CACHE_NONE=0,
+                GW_CACHE_FILL,  //cacheable read, store the result
+                GW_CACHE_HIT    //served from gatewayCache, no SDO transfer
+        } cache;
+        OS_SEM replySem; //posted by processCANGateway() when an SDO frame from nodeId arrives
+	
+} GATEWAY_CONTEXT;
+
+#define GW_STEP_MORE  0xFF //stepCANGateway: more CAN packets are required
+
+//One context per concurrent request. The radio task holds one for its remote request, or BATCH_READ_PARALLEL
+//during a batch read (the remote request is completed first), and the control script lane holds one: 3 at most.
+//Any further request (the background script lane) waits in acquireGatewayContext until a context is released.
+//Each context drives its own CanFestival SDO client line, so requests to different nodes run in parallel. Requests
+//to the same node are serialized because a node has a single SDO server channel.
+//The SDO server takes its line from the same table. Expedited requests use the fast path and hold no line, so a 
+//server transfer is only refused (aborted) while three segmented or block client transfers are in flight.
+//RAM: 76 B per context and about 110 B per SDO line (d->transfers[]).
+static GATEWAY_CONTEXT gatewayPool[ GATEWAY_MAX_CONTEXTS ];
+static OS_MUTEX gatewaySDOLock; //CanFestival SDO line table and timers (SDOTimeoutAlarm), see LockSDOLines()
+
+//Cached remote reads of read-mostly entries. A hit skips the SDO transfer. Entries expire after the TTL of their 
+//index and are dropped when the node boots or is reset (InvalidateCANGatewayCache) or written through the gateway.
+typedef struct
+{
+	CPU_INT16U index;
+	CPU_INT08U nodeId, subIndex;
+	CPU_INT08U len;          //0: unused
+	CPU_BOOLEAN permanent;   //no TTL, kept until invalidated
+	CPU_INT08U value[ GATEWAY_CACHE_VALUE_SIZE ];
+	OS_TICK expires;
+	
+} GATEWAY_CACHE_ENTRY;
+
+typedef struct
+{
+	CPU_INT16U firstIndex, lastIndex;
+	CPU_INT16U ttl;          //seconds, 0: until invalidated
+	
+} GATEWAY_CACHE_TTL;
+
+static const GATEWAY_CACHE_TTL gatewayCacheTTL[] = 
+{
+	{ 0x1000, 0x1000,  0 },  //device type
+	{ 0x1008, 0x100A,  0 },  //device name, hardware and software version
+	{ 0x1018, 0x1018,  0 },  //identity
+	{ 0x1400, 0x1BFF, 60 },  //PDO communication and mapping parameters
+};
+
+static GATEWAY_CACHE_ENTRY gatewayCache[ GATEWAY_CACHE_ENTRIES ];
+static CPU_INT08U gatewayCacheVictim; //round robin replacement when no entry is free or expired
+
+//Radio request routed to a CAN node. The radio task begins the CAN transfer and keeps receiving, so local OD 
+//requests are served while it is in flight. processCANGateway wakes the radio task for each reply from the node
+//(see stepRadioRemote). Only one remote request is in flight.
+typedef struct
+{
+	CPU_INT08U radioBuffer[ MAX_RADIO_BUFFER ]; //copy of the received packet, the response is built in place
+	CPU_INT08U rxBuffer[ MAX_DATA_BUFFER + 2 ];
+	CPU_INT08U rxLen;
+	enum 
+	{	
+		RR_IDLE=0,  //slot free
+		RR_BUSY     //CAN transfer in flight on ctx
+	} state;
+	GATEWAY_CONTEXT *ctx;
+	CPU_INT08U nPackets;  //CAN packets left before the request is aborted
+	OS_TICK startTick;
+	OS_TICK stepTick;     //request sent or last reply, CAN_TIMEOUT_TICKS runs from here
+	
+} RADIO_REMOTE_REQUEST;
+
+static RADIO_REMOTE_REQUEST radioRemote;
+
+//High speed data waiting to be pushed by the radio task (TransferBuffer_StreamMode), filled by processHSPDO.
+//When full, the oldest buffer is dropped and counted in the gap of the next packet sent.
+static struct
+{
+	CPU_INT08U data[ HS_STREAM_SLOTS ][ sizeof(TransferBuffer_Copy) ];
+	CPU_INT08U sequence[ HS_STREAM_SLOTS ];
+	CPU_INT08U head, count; //head: oldest
+	CPU_INT08U gap;         //buffers dropped since the last packet sent
+	CPU_INT08U reference[ sizeof(TransferBuffer_Copy) ]; //last buffer sent, the tower's base for the next delta packet
+	CPU_INT08U referenceSeq;
+	CPU_INT08U sinceKey;    //delta packets sent since the last raw one, 0xFF: no reference (next packet is raw)
 	
-} gateway;
+} hsStream;
 
 
 // -------- LOCAL PROTOTYPES ----------
@@ -74,17 +166,84 @@ CPU_INT08U GetLocalOD( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer, CPU_INT08U *rxL
 CPU_INT08U SetLocalOD( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer, CPU_INT08U *rxLen );
 CPU_INT08U GetBlockOD( PACKET_HEADER *pkt, CPU_INT08U *data, CPU_INT08U *dataLen );
 void processNetworkID0( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer, CPU_INT08U *rxLen );
+static void updateCANGatewayState( GATEWAY_CONTEXT *ctx );
+static void initCANGateway( GATEWAY_CONTEXT *ctx, PACKET_HEADER *pkt, CPU_INT08U *rxBuffer );
+static GATEWAY_CONTEXT * beginCANGateway( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer );
+static CPU_INT08U endCANGateway( GATEWAY_CONTEXT *ctx, CPU_INT08U *rxLenPtr );
+static CPU_INT08U stepCANGateway( GATEWAY_CONTEXT *ctx, CPU_BOOLEAN replied );
+static CPU_INT08U abortCANGateway( GATEWAY_CONTEXT *ctx );
+static CPU_INT08U finishCANGateway( GATEWAY_CONTEXT *ctx, CPU_INT08U status, CPU_INT08U *rxLenPtr );
+static void runBatchRead( PACKET_HEADER *pkt );
+static void runWindowedFileRead( PACKET_HEADER *pkt );
+static const GATEWAY_CACHE_TTL * findCacheTTL( CPU_INT16U index );
+static CPU_BOOLEAN readGatewayCache( GATEWAY_CONTEXT *ctx );
+static void writeGatewayCache( GATEWAY_CONTEXT *ctx, const GATEWAY_CACHE_TTL *ttl );
+static void invalidateGatewayCacheIndex( CPU_INT08U nodeId, CPU_INT16U index );
+static CPU_BOOLEAN startFastSDO( GATEWAY_CONTEXT *ctx );
+static CPU_BOOLEAN stepRadioRemote( CPU_BOOLEAN wait );
+static CPU_BOOLEAN sendHSStreamPacket( void );
+static CPU_INT08U encodeHSDelta( const CPU_INT08U *sample, const CPU_INT08U *reference, CPU_INT08U *out, CPU_INT08U maxLen );
 
  
 //============================
 //    GLOBAL CODE
 //============================
 
-//called by runcanservertask
-//Posts that a CAN SDO packet is available, allowing the gateway task to continue
-void processCANGateway( void )
+//called from InitApp before any task uses the gateway
+void InitCANGateway( void )
+{
+  OS_ERR err;
+  CPU_INT08U i;
+  
+  OSMutexCreate(&gatewaySDOLock, "CAN Gateway SDO Lines", &err);
+  if (err != OS_ERR_NONE) { while(1){asm("nop");}}
+  
+  for (i = 0; i < GATEWAY_MAX_CONTEXTS; i++)
+  {
+    gatewayPool[i].inUse = FALSE;
+    OSSemCreate(&gatewayPool[i].replySem, "CAN Gateway Reply", 0, &err);
+    if (err != OS_ERR_NONE) { while(1){asm("nop");}}
+  }
+  
+  radioRemote.state = RR_IDLE;
+  
+  ResetHSStream();
+}
+
+//called by runcanservertask after processSDO()
+//Posts that a CAN SDO packet from nodeId is available, allowing the request waiting on that node to continue
+void processCANGateway( CPU_INT08U nodeId )
 { 
-  postGatewaySem();
+  OS_ERR err;
+  CPU_INT08U i;
+  
+  for (i = 0; i < GATEWAY_MAX_CONTEXTS; i++)
+  {
+    if (gatewayPool[i].inUse && gatewayPool[i].nodeId == nodeId)
+    {
+      OSSemPost(&gatewayPool[i].replySem, OS_OPT_POST_1, &err);
+      if (&gatewayPool[i] == radioRemote.ctx)
+        wakeRadioReceiver(); //the radio task steps the remote request
+      break;
+    }
+  }
+}
+
+//Serializes access to the CanFestival SDO lines (d->transfers[]) between the CAN server task and the
+//gateway contexts. The lock is only held while a frame is processed or sent, never while waiting for a reply.
+void LockSDOLines( void )
+{
+  OS_ERR err;
+  CPU_TS ts;
+  
+  OSMutexPend(&gatewaySDOLock, 0, OS_OPT_PEND_BLOCKING, &ts, &err);
+}
+
+void UnlockSDOLines( void )
+{
+  OS_ERR err;
+  
+  OSMutexPost(&gatewaySDOLock, OS_OPT_POST_NONE, &err);
 }
 
 void WaitUntilCANGatewayAvailable( void )
@@ -92,64 +251,124 @@ void WaitUntilCANGatewayAvailable( void )
   OS_ERR err;
   CPU_TS ts;
   
-  OSSemPend(&GatewayAccessControl, 0, OS_OPT_PEND_BLOCKING, &ts, &err);
+  OSMutexPend(&GatewayAccessControl, 0, OS_OPT_PEND_BLOCKING, &ts, &err);
 }
 
 void MakeCANGatewayAvailable( void )
 {
   OS_ERR err;
   
-  OSSemPost(&GatewayAccessControl, OS_OPT_POST_1, &err);
+  OSMutexPost(&GatewayAccessControl, OS_OPT_POST_NONE, &err);
+}
+
+//Takes a free context for nodeId. Waits while all contexts are busy or another request to nodeId is in progress.
+static GATEWAY_CONTEXT * acquireGatewayContext( CPU_INT08U nodeId )
+{
+  OS_ERR err;
+  CPU_INT08U i;
+  GATEWAY_CONTEXT *ctx;
+  CPU_SR_ALLOC();
+  
+  while (DEF_TRUE)
+  {
+    ctx = 0;
+    CPU_CRITICAL_ENTER();
+    for (i = 0; i < GATEWAY_MAX_CONTEXTS; i++)
+    {
+      if (gatewayPool[i].inUse)
+      {
+        if (gatewayPool[i].nodeId == nodeId)
+        {
+          ctx = 0; //node busy
+          break;
+        }
+      }
+      else if (ctx == 0)
+      {
+        ctx = &gatewayPool[i];
+      }
+    }
+    if (ctx)
+    {
+      ctx->inUse = TRUE;
+      ctx->nodeId = nodeId;
+    }
+    CPU_CRITICAL_EXIT();
+    
+    if (ctx)
+    {
+      OSSemSet(&ctx->replySem, 0, &err); //discard replies for a previous request
+      return ctx;
+    }
+    
+    OSTimeDlyHMSM(0, 0, 0, MS_PER_TICK, OS_OPT_TIME_HMSM_STRICT, &err); 
+  }
+}
+
+static void releaseGatewayContext( GATEWAY_CONTEXT *ctx )
+{
+  ctx->state = GW_DONE;
+  ctx->inUse = FALSE;
 }
 
-/* updateCANGatewayState is called by runCANGateway */
-void updateCANGatewayState( void )
+/* updateCANGatewayState is called by runCANGateway with the SDO lines locked */
+static void updateCANGatewayState( GATEWAY_CONTEXT *ctx )
 {
 	UNS32 len, abortCode;
 	UNS8 result;
-        static CPU_INT08U tempBuffer[ MAX_DATA_BUFFER ];
-        CPU_INT08U i;
         
-	switch( gateway.state )
+	switch( ctx->state )
 	{
+		case GW_FAST_FALLBACK :
+			
+			//the server started a segmented upload: abort it and read through CanFestival
+			sendSDOabort( &ObjDict_Data, SDO_CLIENT, ctx->nodeId, ctx->index, ctx->subIndex, SDOABT_GENERAL_ERROR );
+			CAN_Gateway_FastFallbacks++;
+			ctx->fast = FALSE;
+			ctx->state = GW_SDO_UPLOAD;
+			//no break
+			
 		case GW_SDO_UPLOAD :
 		
-			result = readNetworkDict( &ObjDict_Data, gateway.nodeId, gateway.index, gateway.subIndex, 0 );
+			if( CAN_Gateway_BlockTransfer )
+			  result = readNetworkDictBlockCallback( &ObjDict_Data, ctx->nodeId, ctx->index, ctx->subIndex, 0, NULL );
+			else
+			  result = readNetworkDict( &ObjDict_Data, ctx->nodeId, ctx->index, ctx->subIndex, 0 );
 			
                         if (result == 0) 
                         {
-                          gateway.state = GW_EXPECTING_SDO_UPLOAD_REPLY;
+                          ctx->state = GW_EXPECTING_SDO_UPLOAD_REPLY;
                         }
 			else if( result == 0xFF || result == 0xFE ) 
 			{
-                          gateway.abortCode = OD_NOT_MAPPABLE; // result returned 0xFF, check for OD entry
-                          gateway.state = GW_DONE;
+                          ctx->abortCode = OD_NOT_MAPPABLE; // result returned 0xFF, check for OD entry
+                          ctx->state = GW_DONE;
 			}
                         else 
                         {
-                          gateway.abortCode = 0xFFFFFFFF;
-                          gateway.state = GW_DONE; //should not get here
+                          ctx->abortCode = 0xFFFFFFFF;
+                          ctx->state = GW_DONE; //should not get here
                         }
 			
 			break;
                         
                  case GW_SDO_BLOCK_UPLOAD :
 		
-			result = readBlockNetworkDict( &ObjDict_Data, gateway.nodeId, gateway.index, \
-                                                        gateway.subIndex, gateway.txDataLen, 0 );
+			result = readBlockNetworkDict( &ObjDict_Data, ctx->nodeId, ctx->index, \
+                                                        ctx->subIndex, ctx->txDataLen, 0 );
 			if (result ==0)
                         {
-                          gateway.state = GW_EXPECTING_SDO_UPLOAD_REPLY ;
+                          ctx->state = GW_EXPECTING_SDO_UPLOAD_REPLY ;
                         }
 			else if( result == 0xFF || result == 0xFE ) 
 			{
-                          gateway.abortCode = OD_NOT_MAPPABLE; // result returned 0xFF, check for OD entry
-                          gateway.state = GW_DONE;
+                          ctx->abortCode = OD_NOT_MAPPABLE; // result returned 0xFF, check for OD entry
+                          ctx->state = GW_DONE;
 			}
 			else 
                         {
-                          gateway.abortCode = 0xFFFFFFFF;
-                          gateway.state = GW_DONE; //should not get here
+                          ctx->abortCode = 0xFFFFFFFF;
+                          ctx->state = GW_DONE; //should not get here
                         }
 			break;
 			
@@ -158,32 +377,29 @@ void updateCANGatewayState( void )
 			
 			len = SDO_MAX_LENGTH_TRANSFER;
 			
-			result = getReadResultNetworkDict( &ObjDict_Data, gateway.nodeId, tempBuffer, &len, &abortCode );
+			//rxData holds at least SDO_MAX_LENGTH_TRANSFER bytes and is only written on SDO_FINISHED,
+			//so the result is copied directly (no shared buffer between contexts)
+			result = getReadResultNetworkDict( &ObjDict_Data, ctx->nodeId, ctx->rxData, &len, &abortCode );
                        
 			if( result == SDO_FINISHED )
 			{
-                          
-                          //Copy data to tempBuffer
-                          for (i = 0; i < len; i++)
-                            gateway.rxData[i] = tempBuffer[i];
-                          
-                          gateway.rxDataLen = len;	
-                          gateway.abortCode = 0;
-                          gateway.state = GW_DONE;                        	
+                          ctx->rxDataLen = len;	
+                          ctx->abortCode = 0;
+                          ctx->state = GW_DONE;                        	
 			}                      
                         else if (result == SDO_ABORTED_RCV || result == SDO_ABORTED_INTERNAL || result == 0xFF || result == 0xFE)      
                         {
-                          gateway.rxDataLen = 0x04; 
+                          ctx->rxDataLen = 0x04; 
                           
                           if (abortCode == 0)
                           {
-                            gateway.abortCode = 0x06040048;    
+                            ctx->abortCode = 0x06040048;    
                           } 
                           else
                           {
-                            gateway.abortCode = abortCode;
+                            ctx->abortCode = abortCode;
                           }
-                          gateway.state = GW_DONE;  
+                          ctx->state = GW_DONE;  
 
                         }
                         else if ( result == SDO_UPLOAD_IN_PROGRESS || result == SDO_BLOCK_UPLOAD_IN_PROGRESS)
@@ -192,57 +408,61 @@ void updateCANGatewayState( void )
                         }
                         else
                         {
-                          gateway.abortCode = 0xFFFFFFFF; //shouldn't get here
-                          gateway.state = GW_DONE; 
+                          ctx->abortCode = 0xFFFFFFFF; //shouldn't get here
+                          ctx->state = GW_DONE; 
                         }
                         break;
 
 		case GW_SDO_DOWNLOAD :
 			
-			result = writeNetworkDict( &ObjDict_Data, gateway.nodeId, gateway.index, \
-								gateway.subIndex, gateway.txDataLen, 0, gateway.txData );		
+			if( CAN_Gateway_BlockTransfer && ctx->txDataLen > 7 ) //one sub-block instead of a confirmed segment per 7 bytes
+			  result = writeNetworkDictBlockCallback( &ObjDict_Data, ctx->nodeId, ctx->index, \
+								ctx->subIndex, ctx->txDataLen, 0, ctx->txData, NULL );
+			else
+			  result = writeNetworkDict( &ObjDict_Data, ctx->nodeId, ctx->index, \
+								ctx->subIndex, ctx->txDataLen, 0, ctx->txData );		
 			
                         if (result == 0)
                         {
-                          gateway.state = GW_EXPECTING_SDO_DOWNLOAD_REPLY ;
+                          ctx->state = GW_EXPECTING_SDO_DOWNLOAD_REPLY ;
                         }
                         else if( result == SDO_ABORTED_RCV || result == SDO_ABORTED_INTERNAL || result == 0xFF || result == 0xFE) 
 			{
-                          gateway.abortCode = SDOABT_GENERAL_ERROR; // result returned 0xFF, check for OD entry
-                          gateway.state = GW_DONE;
+                          ctx->abortCode = SDOABT_GENERAL_ERROR; // result returned 0xFF, check for OD entry
+                          ctx->state = GW_DONE;
 			}
                         else
                         {
-                          gateway.abortCode = 0xFFFFFFFF; //shouldn't get here
-                          gateway.state = GW_DONE; 
+                          ctx->abortCode = 0xFFFFFFFF; //shouldn't get here
+                          ctx->state = GW_DONE; 
                         }
 			
 			break;
 		
 		case GW_EXPECTING_SDO_DOWNLOAD_REPLY :
 			
-			result = getWriteResultNetworkDict( &ObjDict_Data, gateway.nodeId, &abortCode );
+			result = getWriteResultNetworkDict( &ObjDict_Data, ctx->nodeId, &abortCode );
 
                         
                         if (result == SDO_FINISHED)
                         {
-                          memset(gateway.rxData, 0, gateway.rxDataLen);
-                          gateway.rxDataLen = 1;
-                          gateway.abortCode = 0;
-                          gateway.state = GW_DONE;
+                          memset(ctx->rxData, 0, ctx->rxDataLen);
+                          ctx->rxDataLen = 1;
+                          ctx->abortCode = 0;
+                          ctx->state = GW_DONE;
                         }
 			else if (result == SDO_ABORTED_RCV || result == SDO_ABORTED_INTERNAL || result == 0xFF || result == 0xFE)
                         {
-                          gateway.rxDataLen = 0x04;  
+                          ctx->rxDataLen = 0x04;  
                           if (abortCode == 0)
                           {
-                            gateway.abortCode = 0x06040048;    
+                            ctx->abortCode = 0x06040048;    
                           }
                           else
                           {
-                            gateway.abortCode = abortCode;
+                            ctx->abortCode = abortCode;
                           }
-			  gateway.state = GW_DONE;
+			  ctx->state = GW_DONE;
                        }
                        else if (result == SDO_DOWNLOAD_IN_PROGRESS || result == SDO_BLOCK_DOWNLOAD_IN_PROGRESS)
                        {
@@ -250,8 +470,8 @@ void updateCANGatewayState( void )
                        }
                        else
                       {
-                        gateway.abortCode = 0xFFFFFFFF; //shouldn't get here
-                        gateway.state = GW_DONE; 
+                        ctx->abortCode = 0xFFFFFFFF; //shouldn't get here
+                        ctx->state = GW_DONE; 
                       }         
                       break;
                         	
@@ -261,66 +481,154 @@ void updateCANGatewayState( void )
 			break;
 	}
         
-        if( gateway.state == GW_DONE )
-          closeSDOtransfer (&ObjDict_Data, gateway.nodeId, SDO_CLIENT ); 
+        if( ctx->state == GW_DONE && !ctx->fast )
+          closeSDOtransfer (&ObjDict_Data, ctx->nodeId, SDO_CLIENT ); 
 }
 
 
 
-void initCANGateway( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer)
+static void initCANGateway( GATEWAY_CONTEXT *ctx, PACKET_HEADER *pkt, CPU_INT08U *rxBuffer)
 {
        
-	gateway.channel  	= pkt->networkId;		
-	gateway.nodeId   	= pkt->nodeId;
-	gateway.index    	= (pkt->hbIndex << 8) + pkt->lbIndex;
-	gateway.subIndex 	= pkt->subIndex;
-	gateway.rxData   	= rxBuffer;
-	gateway.txData   	= &pkt->data;
-	gateway.txDataLen       = pkt->dataLen;
-        gateway.state           = GW_DONE;
+	ctx->channel  	= pkt->networkId;		
+	ctx->index    	= (pkt->hbIndex << 8) + pkt->lbIndex;
+	ctx->subIndex 	= pkt->subIndex;
+	ctx->rxData   	= rxBuffer;
+	ctx->rxDataLen  = 0;
+	ctx->txData   	= &pkt->data;
+	ctx->txDataLen  = pkt->dataLen;
+	ctx->abortCode  = 0;
+        ctx->state      = GW_DONE;
+        ctx->cache      = GW_CACHE_NONE;
+        ctx->fast       = FALSE;
 	
 	if( pkt->protoCtrl == 0xA4 || pkt->protoCtrl == 0xE4 )
 	{
-		gateway.state = GW_SDO_DOWNLOAD; //write
+		ctx->state = GW_SDO_DOWNLOAD; //write
 	}
 	else if ( pkt->protoCtrl == 0x24 || pkt->protoCtrl == 0x64)
 	{
-		gateway.state = GW_SDO_UPLOAD; //read
+		ctx->state = GW_SDO_UPLOAD; //read
 	}
 	else if ( pkt->protoCtrl == 0x30 )
         {
-                gateway.state = GW_SDO_BLOCK_UPLOAD; 
+                ctx->state = GW_SDO_BLOCK_UPLOAD; 
         }
 	
         
 }
 
-//CPU_INT08U getCanPacket( CPU_INT08U *rxLen )
-//{       
-//        if( gateway.state != GW_DONE )
-//	{
-//          return 0;
-//        }
-//        
-//        if( gateway.abortCode == OD_SUCCESSFUL )
-//        {
-//                *rxLen = gateway.rxDataLen;
-//                return 1;
-//                
-//        }
-//        else
-//        {		
-//                *(CPU_INT32U *)gateway.rxData = gateway.abortCode;
-//                *rxLen = 4 ;		
-//                return 2;
-//        }
-//}
-
-//must setup gateway structure before running
+static const GATEWAY_CACHE_TTL * findCacheTTL( CPU_INT16U index )
+{
+  CPU_INT08U i;
+  
+  for( i = 0; i < sizeof(gatewayCacheTTL)/sizeof(gatewayCacheTTL[0]); i++ )
+  {
+    if( index >= gatewayCacheTTL[i].firstIndex && index <= gatewayCacheTTL[i].lastIndex )
+      return &gatewayCacheTTL[i];
+  }
+  return 0;
+}
+
+//Copies a cached value for ctx into ctx->rxData. Returns TRUE on a hit.
+static CPU_BOOLEAN readGatewayCache( GATEWAY_CONTEXT *ctx )
+{
+  OS_ERR err;
+  CPU_INT08U i;
+  CPU_BOOLEAN hit = FALSE;
+  OS_TICK now = OSTimeGet(&err);
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  for( i = 0; i < GATEWAY_CACHE_ENTRIES; i++ )
+  {
+    GATEWAY_CACHE_ENTRY *e = &gatewayCache[i];
+    
+    if( e->len && e->nodeId == ctx->nodeId && e->index == ctx->index && e->subIndex == ctx->subIndex )
+    {
+      if( e->permanent || (OS_TICK)(e->expires - now) < 0x80000000 ) //rollover safe
+      {
+        memcpy(ctx->rxData, e->value, e->len);
+        ctx->rxDataLen = e->len;
+        hit = TRUE;
+      }
+      else
+      {
+        e->len = 0; //expired
+      }
+      break;
+    }
+  }
+  CPU_CRITICAL_EXIT();
+  
+  return hit;
+}
+
+//Stores the result of a completed cacheable read
+static void writeGatewayCache( GATEWAY_CONTEXT *ctx, const GATEWAY_CACHE_TTL *ttl )
+{
+  OS_ERR err;
+  CPU_INT08U i;
+  GATEWAY_CACHE_ENTRY *e = 0;
+  OS_TICK now = OSTimeGet(&err);
+  CPU_SR_ALLOC();
+  
+  if( ctx->rxDataLen == 0 || ctx->rxDataLen > GATEWAY_CACHE_VALUE_SIZE )
+    return;
+  
+  CPU_CRITICAL_ENTER();
+  for( i = 0; i < GATEWAY_CACHE_ENTRIES; i++ ) //free or expired entry
+  {
+    if( gatewayCache[i].len == 0 || 
+       (!gatewayCache[i].permanent && (OS_TICK)(gatewayCache[i].expires - now) >= 0x80000000) )
+    {
+      e = &gatewayCache[i];
+      break;
+    }
+  }
+  if( e == 0 )
+  {
+    e = &gatewayCache[gatewayCacheVictim];
+    if( ++gatewayCacheVictim >= GATEWAY_CACHE_ENTRIES )
+      gatewayCacheVictim = 0;
+  }
+  
+  e->nodeId = ctx->nodeId;
+  e->index = ctx->index;
+  e->subIndex = ctx->subIndex;
+  e->permanent = (ttl->ttl == 0);
+  e->expires = now + ((OS_TICK)ttl->ttl * 1000)/MS_PER_TICK;
+  memcpy(e->value, ctx->rxData, ctx->rxDataLen);
+  e->len = ctx->rxDataLen;
+  CPU_CRITICAL_EXIT();
+}
+
+//Drops the cached subindexes of an index written through the gateway
+static void invalidateGatewayCacheIndex( CPU_INT08U nodeId, CPU_INT16U index )
+{
+  CPU_INT08U i;
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  for( i = 0; i < GATEWAY_CACHE_ENTRIES; i++ )
+  {
+    if( gatewayCache[i].len && gatewayCache[i].nodeId == nodeId && gatewayCache[i].index == index )
+    {
+      gatewayCache[i].len = 0;
+      CAN_Gateway_CacheInvalidations++;
+    }
+  }
+  CPU_CRITICAL_EXIT();
+}
+
+//Runs one SDO request in its own gateway context. May be called concurrently by the radio task and both 
+//script lanes; no external locking is required.
 //Inputs:
 //pkt: pointer to the PACKET_HEADER struct that defines the node,index,subindex, and what SDO mechanism to use
 // If an SDO write (download), pkt->data and pkt->dataLen define the data to write
-//rxBuffer is used to output the SDO response, rxLenPtr is used to output the SDO response length (in bytes)
+//rxBuffer is used to output the SDO response (at least SDO_MAX_LENGTH_TRANSFER bytes), 
+//rxLenPtr is used to output the SDO response length (in bytes)
+//On error rxBuffer holds the 4 byte abort code (LSB first) and *rxLenPtr is 4
 //Returns:
 //0: success
 //1: TX error
@@ -331,59 +639,265 @@ void initCANGateway( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer)
 
 CPU_INT08U runCANGateway(PACKET_HEADER *pkt, CPU_INT08U *rxBuffer, CPU_INT08U* rxLenPtr) 
 {
-  CPU_INT08U nPackets = MAX_CAN_TRANSFERS_APP;
+  return endCANGateway( beginCANGateway(pkt, rxBuffer), rxLenPtr );
+}
+
+//First half of runCANGateway: takes a context for pkt->nodeId and sends the first SDO frame.
+//Several requests to different nodes may be begun before waiting on any of them (see runBatchRead).
+static GATEWAY_CONTEXT * beginCANGateway( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer )
+{
+  GATEWAY_CONTEXT *ctx = acquireGatewayContext(pkt->nodeId);
   
-  initCANGateway(pkt, rxBuffer);
+  initCANGateway(ctx, pkt, rxBuffer);
   
-  updateCANGatewayState();
-  if( gateway.state == GW_DONE )
+  if( ctx->state == GW_SDO_UPLOAD && findCacheTTL(ctx->index) )
   {
-    *rxLenPtr = gateway.rxDataLen; 
-    return 1;
+    if( readGatewayCache(ctx) )
+    {
+      ctx->cache = GW_CACHE_HIT;
+      ctx->state = GW_DONE;
+      CAN_Gateway_CacheHits++;
+      return ctx;
+    }
+    ctx->cache = GW_CACHE_FILL;
+    CAN_Gateway_CacheMisses++;
   }
+  else if( ctx->state == GW_SDO_DOWNLOAD || pkt->protoCtrl == 0xB0 )
+  {
+    invalidateGatewayCacheIndex(ctx->nodeId, ctx->index);
+  }
+  
+  ctx->startTime = GetTimer1Count();
+  if( (ctx->state == GW_SDO_UPLOAD || (ctx->state == GW_SDO_DOWNLOAD && ctx->txDataLen <= 4)) && startFastSDO(ctx) )
+    return ctx;
+  
+  LockSDOLines();
+  updateCANGatewayState(ctx);
+  UnlockSDOLines();
+  
+  return ctx;
+}
 
+//Expedited (<= 4 byte) transfers bypass the CanFestival SDO lines: the initiate frame is built here and the 
+//response is decoded straight into ctx->rxData by completeCANGatewayFastSDO. An upload whose value turns out 
+//to be longer falls back to the CanFestival path (GW_FAST_FALLBACK). Returns FALSE if the frame was not sent.
+static CPU_BOOLEAN startFastSDO( GATEWAY_CONTEXT *ctx )
+{
+  s_SDO sdo;
+  UNS8 result;
   
-  while ( nPackets-- ) 
+  sdo.nodeId = ctx->nodeId;
+  memset(sdo.body.data, 0, 8);
+  if( ctx->state == GW_SDO_UPLOAD )
   {
-    OS_ERR err = pendGatewaySem(CAN_TIMEOUT_TICKS);  //               
-    if( err == OS_ERR_NONE)  
-    { 
-      updateCANGatewayState();
-      if(gateway.state == GW_DONE)
-      {
-        if( gateway.abortCode == OD_SUCCESSFUL )
-        {
-          *rxLenPtr = gateway.rxDataLen; 
-          return 0;    
-        }
-        else
-        {
-          *rxLenPtr = gateway.rxDataLen;  
-          return 2;
-        }
-      }
-      //else continues at beginning of while: more CAN packets required
-      //until gateway.state reaches GW_DONE.  
+    sdo.body.data[0] = 0x40;  //initiate upload
+  }
+  else
+  {
+    sdo.body.data[0] = 0x23 | ((4 - ctx->txDataLen) << 2); //initiate expedited download, size indicated
+    memcpy(&sdo.body.data[4], ctx->txData, ctx->txDataLen);
+  }
+  sdo.body.data[1] = (UNS8)ctx->index;
+  sdo.body.data[2] = (UNS8)(ctx->index >> 8);
+  sdo.body.data[3] = ctx->subIndex;
+  
+  LockSDOLines();
+  ctx->fast = TRUE; //set before sending: the reply may be processed before sendSDO returns
+  ctx->state = (ctx->state == GW_SDO_UPLOAD) ? GW_FAST_UPLOAD_REPLY : GW_FAST_DOWNLOAD_REPLY;
+  result = sendSDO( &ObjDict_Data, SDO_CLIENT, sdo );
+  if( result )
+  {
+    ctx->fast = FALSE;
+    ctx->state = (ctx->state == GW_FAST_UPLOAD_REPLY) ? GW_SDO_UPLOAD : GW_SDO_DOWNLOAD;
+  }
+  UnlockSDOLines();
+  
+  return (result == 0);
+}
+
+//called by canDispatch with the SDO lines locked, before processSDO()
+//Completes a fast path request waiting on the node that sent the frame. Returns TRUE if the frame was consumed.
+CPU_BOOLEAN completeCANGatewayFastSDO( CPU_INT16U cobId, const CPU_INT08U *data )
+{
+  CPU_INT08U i, n;
+  CPU_INT08U nodeId = (CPU_INT08U)(cobId & 0x7F);
+  GATEWAY_CONTEXT *ctx = 0;
+  
+  if( (cobId & 0x780) != 0x580 ) //server to client frames only
+    return FALSE;
+  
+  for (i = 0; i < GATEWAY_MAX_CONTEXTS; i++)
+  {
+    if (gatewayPool[i].inUse && gatewayPool[i].nodeId == nodeId && 
+        (gatewayPool[i].state == GW_FAST_UPLOAD_REPLY || gatewayPool[i].state == GW_FAST_DOWNLOAD_REPLY))
+    {
+      ctx = &gatewayPool[i];
+      break;
     }
-    else //timeout
+  }
+  if( ctx == 0 || data[1] != (UNS8)ctx->index || data[2] != (UNS8)(ctx->index >> 8) 
+     || data[3] != ctx->subIndex )
+    return FALSE;
+  
+  if( data[0] == 0x80 ) //abort
+  {
+    ctx->abortCode = data[4] | ((UNS32)data[5] << 8) | ((UNS32)data[6] << 16) | ((UNS32)data[7] << 24);
+    ctx->rxDataLen = 4;
+    ctx->state = GW_DONE;
+  }
+  else if( ctx->state == GW_FAST_UPLOAD_REPLY && (data[0] & 0xE0) == 0x40 )
+  {
+    if( data[0] & 0x02 ) //expedited
     {
-      //Must close out and set abort code, because CAN gateway did not complete
-      closeSDOtransfer (&ObjDict_Data, gateway.nodeId, SDO_CLIENT ); 
-      gateway.state = GW_DONE;
-      gateway.abortCode = SDOABT_APP_TIMEOUT;
-      *rxLenPtr = gateway.rxDataLen; 
-      return 3;
+      n = (data[0] & 0x01) ? 4 - ((data[0] >> 2) & 0x03) : 4;
+      memcpy(ctx->rxData, &data[4], n);
+      ctx->rxDataLen = n;
+      ctx->abortCode = 0;
+      ctx->state = GW_DONE;
     }
-  }//end of while
+    else
+    {
+      ctx->state = GW_FAST_FALLBACK;
+    }
+  }
+  else if( ctx->state == GW_FAST_DOWNLOAD_REPLY && (data[0] & 0xE0) == 0x60 )
+  {
+    ctx->rxData[0] = 0;
+    ctx->rxDataLen = 1;
+    ctx->abortCode = 0;
+    ctx->state = GW_DONE;
+  }
+  else
+  {
+    ctx->abortCode = SDOABT_GENERAL_ERROR;
+    ctx->rxDataLen = 4;
+    ctx->state = GW_DONE;
+  }
+  return TRUE;
+}
+
+//Second half of runCANGateway: waits for the request begun on ctx to complete and releases the context.
+//Output and return values as for runCANGateway.
+static CPU_INT08U endCANGateway( GATEWAY_CONTEXT *ctx, CPU_INT08U *rxLenPtr )
+{
+  CPU_INT08U nPackets = MAX_CAN_TRANSFERS_APP;
+  CPU_INT08U status;
+  OS_ERR err = OS_ERR_NONE;
+  CPU_TS ts;
+  
+  do
+  {
+    if( ctx->state != GW_DONE )
+      OSSemPend(&ctx->replySem, CAN_TIMEOUT_TICKS, OS_OPT_PEND_BLOCKING, &ts, &err);
+    status = stepCANGateway(ctx, err == OS_ERR_NONE);
+    //continues while more CAN packets are required
+  } while( status == GW_STEP_MORE && --nPackets );
+  
+  if( status == GW_STEP_MORE )
+    status = abortCANGateway(ctx); //too many packets
+  
+  return finishCANGateway(ctx, status, rxLenPtr);
+}
+
+//Advances the request on ctx after a reply from the node (replied) or closes it on a timeout. Returns 
+//GW_STEP_MORE while more CAN packets are required, else the runCANGateway status.
+static CPU_INT08U stepCANGateway( GATEWAY_CONTEXT *ctx, CPU_BOOLEAN replied )
+{
+  CPU_INT08U status = GW_STEP_MORE;
+  
+  LockSDOLines();
+  if( ctx->state == GW_DONE )
+  {
+    //completed before the wait: served from the cache, not sent, or fast path reply (completeCANGatewayFastSDO)
+    if( ctx->abortCode == OD_SUCCESSFUL )
+      status = 0;
+    else
+      status = ctx->fast ? 2 : 1;
+  }
+  else if( replied )  
+  { 
+    updateCANGatewayState(ctx);
+    if( ctx->state == GW_DONE )
+      status = (ctx->abortCode == OD_SUCCESSFUL) ? 0 : 2;
+  }
+  else //timeout
+  {
+    //Must close out and set abort code, because CAN gateway did not complete
+    if( !ctx->fast )
+      closeSDOtransfer (&ObjDict_Data, ctx->nodeId, SDO_CLIENT ); 
+    ctx->state = GW_DONE;
+    ctx->abortCode = SDOABT_APP_TIMEOUT;
+    status = 3;
+  }
+  UnlockSDOLines();
   
-  //too many packets...
+  return status;
+}
+
+//Closes a request that needed more than MAX_CAN_TRANSFERS_APP packets. Returns the runCANGateway status.
+static CPU_INT08U abortCANGateway( GATEWAY_CONTEXT *ctx )
+{
   //Must close out and set abort code, because CAN gateway did not complete
-  closeSDOtransfer (&ObjDict_Data, gateway.nodeId, SDO_CLIENT ); 
-  gateway.state = GW_DONE;
-  gateway.abortCode = SDOABT_OUT_OF_MEMORY;
-  *rxLenPtr = gateway.rxDataLen; 
+  LockSDOLines();
+  if( !ctx->fast )
+    closeSDOtransfer (&ObjDict_Data, ctx->nodeId, SDO_CLIENT ); 
+  ctx->state = GW_DONE;
+  UnlockSDOLines();
+  ctx->abortCode = SDOABT_OUT_OF_MEMORY;
   return 4;
+}
+
+//Outputs the result of the completed request on ctx (see runCANGateway) and releases the context. Returns status.
+static CPU_INT08U finishCANGateway( GATEWAY_CONTEXT *ctx, CPU_INT08U status, CPU_INT08U *rxLenPtr )
+{
+  CPU_INT08U *rxBuffer = ctx->rxData;
   
+  if (status)
+  {
+    //error: copy abortcode into rxBuffer
+    rxBuffer[0] =  (CPU_INT08U)ctx->abortCode;       //LSB
+    rxBuffer[1] =  (CPU_INT08U)(ctx->abortCode >>  8);
+    rxBuffer[2] =  (CPU_INT08U)(ctx->abortCode >> 16);
+    rxBuffer[3] =  (CPU_INT08U)(ctx->abortCode >> 24); //MSB
+    ctx->rxDataLen = 4;
+  }
+  else if( ctx->cache != GW_CACHE_HIT )
+  {
+    //request to reply latency, timer 1 counts 8 us
+    CPU_INT32U latency = (GetTimer1Count() - ctx->startTime) * 8;
+    if( latency > 0xFFFF )
+      latency = 0xFFFF;
+    if( ctx->fast )
+      CAN_Gateway_FastLatency = (UNS16)latency;
+    else
+      CAN_Gateway_SlowLatency = (UNS16)latency;
+    
+    if( ctx->cache == GW_CACHE_FILL )
+      writeGatewayCache(ctx, findCacheTTL(ctx->index));
+  }
+  
+  *rxLenPtr = ctx->rxDataLen; 
+  releaseGatewayContext(ctx);
+  return status;
+}
+
+//Drops all cached entries of nodeId (0: all nodes). Called when a node boots or is reset, see processNODE_GUARD
+//and masterSendNMTstateChange.
+void InvalidateCANGatewayCache( CPU_INT08U nodeId )
+{
+  CPU_INT08U i;
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  for( i = 0; i < GATEWAY_CACHE_ENTRIES; i++ )
+  {
+    if( gatewayCache[i].len && (nodeId == 0 || gatewayCache[i].nodeId == nodeId) )
+    {
+      gatewayCache[i].len = 0;
+      CAN_Gateway_CacheInvalidations++;
+    }
+  }
+  CPU_CRITICAL_EXIT();
 }
 
 
@@ -409,6 +923,18 @@ void runRadioGateway( void )
         {
          
           Status_TestValue8++;
+          
+          if( radioRemote.state == RR_BUSY && !isRadioInSession() )
+          {
+            //the tower left the session and the channel loop can't be woken: complete the remote request first
+            stepRadioRemote( DEF_TRUE );
+          }
+          
+          //push high speed data while the tower is listening (no acknowledge)
+          while( TransferBuffer_StreamMode && isRadioInSession() && sendHSStreamPacket() )
+          {
+          }
+          
           /* clear buffer first, then read MEI packet from radio port */
           memset( radioBuffer, '\0', sizeof(radioBuffer) );
           memset( rxBuffer, '\0', sizeof(rxBuffer) ); //JML added
@@ -428,6 +954,9 @@ void runRadioGateway( void )
                   
                   if( (pkt->nodeId == getNodeId(&ObjDict_Data) || pkt->protoCtrl == 0x34 ) ) // local OD processing or NMT
                   {
+                    if( radioRemote.state == RR_BUSY )
+                      RADIO_Remote_Overlapped++;
+                    
                           /* check protocol byte first -- look for NMT message */
                     switch (pkt->protoCtrl)
                     {
@@ -515,6 +1044,16 @@ void runRadioGateway( void )
                             SetBlockOD (pkt, rxBuffer, &rxLen ); //JML TODO: handle error response
                             break;
                           }
+                      case PKT_PC_BATCH_READ:  //////// BATCHED READ (PM and remote nodes) ///////////////////////////////
+                          {
+                            if( radioRemote.state == RR_BUSY )
+                            {
+                              stepRadioRemote( DEF_TRUE ); //the radio task holds at most BATCH_READ_PARALLEL contexts
+                            }
+                            runBatchRead( pkt ); //sends its own response packet(s)
+                            sendResponse = FALSE;
+                            break;
+                          }
                           
                       case 0x3C:  //////////////// REMOTE MODULE DOWNLOAD /////////////////////////////////////////
                           { 
@@ -543,6 +1082,11 @@ void runRadioGateway( void )
                           sendResponse = TRUE;                       
                           
                         }
+                        else if ((pkt->counter >> 4) == PKT_FILE_WINDOW_READ)
+                        {
+                          runWindowedFileRead( pkt );
+                          sendResponse = FALSE; 
+                        }
                         else if ((pkt->counter >> 4) == 0xD && ReadFileExternal( pkt, rxBuffer, &rxLen) == 0)
                         {
                           /* Normal packet response   */
@@ -574,23 +1118,24 @@ void runRadioGateway( void )
                   } 
                   else if (pkt->networkId == 1 && pkt->nodeId != getNodeId(&ObjDict_Data)) // remote OD processing
                   {                             
-                      WaitUntilCANGatewayAvailable(); 
-                      
-                      if(runCANGateway(pkt, rxBuffer, &rxLen))
-                      { 
-                        //error: copy abortcode into rxBuffer
-                        rxBuffer[0] =  (CPU_INT08U)gateway.abortCode;       //LSB
-                        rxBuffer[1] =  (CPU_INT08U)(gateway.abortCode >>  8);
-                        rxBuffer[2] =  (CPU_INT08U)(gateway.abortCode >> 16);
-                        rxBuffer[3] =  (CPU_INT08U)(gateway.abortCode >> 24); //MSB
-                        rxLen = 4;	
-                        pkt->nodeId |= 0x80; //specify error response
+                      //only one remote request in flight: complete the previous one and send its response first
+                      if( radioRemote.state == RR_BUSY )
+                      {
+                        stepRadioRemote( DEF_TRUE );
                       }
                       
-                      MakeCANGatewayAvailable();
-                                                                
-                      sendRadioResponse( pkt, rxBuffer, rxLen );
-                                                             
+                      //begin the CAN transfer, then listen for the next request while it is in flight
+                      memcpy( radioRemote.radioBuffer, radioBuffer, sizeof(radioBuffer) );
+                      memset( radioRemote.rxBuffer, '\0', sizeof(radioRemote.rxBuffer) );
+                      radioRemote.startTick = OSTimeGet(&err);
+                      radioRemote.nPackets = MAX_CAN_TRANSFERS_APP;
+                      radioRemote.state = RR_BUSY;
+                      RADIO_Remote_Requests++;
+                      radioRemote.ctx = beginCANGateway( (PACKET_HEADER *)&radioRemote.radioBuffer[2], radioRemote.rxBuffer );
+                      radioRemote.stepTick = OSTimeGet(&err);
+                      
+                      if( !stepRadioRemote( DEF_FALSE ) )
+                        enableRadioReceiver();
                   }
                                                   
                   else //JML NOTE: logically can't get here based.  Previous elseif conditions account for all possible cases
@@ -605,8 +1150,9 @@ void runRadioGateway( void )
           } 
           else		
           {
-            // insufficient packet len - turn back on receiver
-            enableRadioReceiver();    
+            // insufficient packet len (or woken to step the remote request) - turn back on receiver
+            if( radioRemote.state != RR_BUSY || !stepRadioRemote( DEF_FALSE ) )
+              enableRadioReceiver();    
             
           }
           
@@ -625,6 +1171,204 @@ void runRadioGateway( void )
 }
 	
 
+//Steps the remote request in flight (radioRemote) with the replies received so far, or until it completes (wait).
+//When it completes the response is sent and DEF_TRUE returned, else the radio task is woken again on the timeout.
+//Radio task only.
+static CPU_BOOLEAN stepRadioRemote( CPU_BOOLEAN wait )
+{
+  GATEWAY_CONTEXT *ctx = radioRemote.ctx;
+  PACKET_HEADER *pkt = (PACKET_HEADER *)&radioRemote.radioBuffer[2];
+  CPU_INT08U status;
+  OS_TICK elapsed, latency;
+  OS_ERR err;
+  CPU_TS ts;
+  
+  do
+  {
+    elapsed = OSTimeGet(&err) - radioRemote.stepTick;
+    err = OS_ERR_NONE;
+    if( ctx->state != GW_DONE ) //else completed before the wait, see stepCANGateway
+    {
+      if( wait && elapsed < CAN_TIMEOUT_TICKS )
+        OSSemPend(&ctx->replySem, CAN_TIMEOUT_TICKS - elapsed, OS_OPT_PEND_BLOCKING, &ts, &err);
+      else
+        OSSemPend(&ctx->replySem, 0, OS_OPT_PEND_NON_BLOCKING, &ts, &err);
+    }
+    
+    if( err != OS_ERR_NONE && !wait && elapsed < CAN_TIMEOUT_TICKS )
+    {
+      wakeRadioReceiverAfter(CAN_TIMEOUT_TICKS - elapsed); //no reply yet
+      return DEF_FALSE;
+    }
+    
+    status = stepCANGateway(ctx, err == OS_ERR_NONE);
+    radioRemote.stepTick = OSTimeGet(&err);
+    if( status == GW_STEP_MORE && --radioRemote.nPackets == 0 )
+      status = abortCANGateway(ctx); //too many packets
+    
+  } while( status == GW_STEP_MORE );
+  
+  wakeRadioReceiverAfter(0);
+  radioRemote.ctx = 0;
+  if( finishCANGateway(ctx, status, &radioRemote.rxLen) )
+  { 
+    //error: rxBuffer holds the abortcode
+    pkt->nodeId |= 0x80; //specify error response
+  }
+  
+  latency = (OSTimeGet(&err) - radioRemote.startTick) * MS_PER_TICK;
+  RADIO_Remote_Latency = (latency > 0xFFFF) ? 0xFFFF : (UNS16)latency;
+  if( RADIO_Remote_Latency > RADIO_Remote_LatencyMax )
+    RADIO_Remote_LatencyMax = RADIO_Remote_Latency;
+  
+  sendRadioResponse( pkt, radioRemote.rxBuffer, radioRemote.rxLen );
+  radioRemote.state = RR_IDLE;
+  return DEF_TRUE;
+}
+
+//Called by processHSPDO (CAN server task, interrupts disabled) for each filled HS buffer in streaming mode.
+//Returns FALSE if the tower is not in session: nothing would be sent, the buffer is not queued
+CPU_BOOLEAN QueueHSStream( const CPU_INT08U *data, CPU_INT08U sequence )
+{
+  CPU_INT08U slot;
+  CPU_SR_ALLOC();
+  
+  if( !isRadioInSession() )
+    return DEF_FALSE;
+  
+  CPU_CRITICAL_ENTER();
+  if( hsStream.count == HS_STREAM_SLOTS ) //drop the oldest, the tower sees the gap
+  {
+    hsStream.head = (hsStream.head + 1) % HS_STREAM_SLOTS;
+    hsStream.count--;
+    if( hsStream.gap < 0xFF )
+      hsStream.gap++;
+    TransferBuffer_StreamDrops++;
+  }
+  slot = (hsStream.head + hsStream.count) % HS_STREAM_SLOTS;
+  memcpy( hsStream.data[slot], data, sizeof(TransferBuffer_Copy) );
+  hsStream.sequence[slot] = sequence;
+  hsStream.count++;
+  CPU_CRITICAL_EXIT();
+  return DEF_TRUE;
+}
+
+//Called by processHSPDO, with interrupts enabled, after QueueHSStream queued a buffer: wakes the radio task
+//to send it.  Only while the tower is in session, a wake restarts the receiver (WOR/channel loop) otherwise
+void WakeHSStream( void )
+{
+  if( isRadioInSession() )
+    wakeRadioReceiver();
+}
+
+//Discards queued HS data, called when recording (re)starts
+void ResetHSStream( void )
+{
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  hsStream.head = 0;
+  hsStream.count = 0;
+  hsStream.gap = 0;
+  hsStream.sinceKey = 0xFF;
+  CPU_CRITICAL_EXIT();
+}
+
+//Sends the oldest queued HS buffer as a PKT_PC_HS_STREAM packet, or as PKT_PC_HS_STREAM_DELTA when 
+//TransferBuffer_StreamCodec is set and the coded buffer is smaller. Radio task only. Returns FALSE if none queued.
+static CPU_BOOLEAN sendHSStreamPacket( void )
+{
+  PACKET_HEADER *pkt = (PACKET_HEADER *)&radioBuffer[2];
+  CPU_INT08U sample[ sizeof(TransferBuffer_Copy) ];
+  CPU_INT08U gap, len = 0;
+  CPU_INT32U start, stop;
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  if( hsStream.count == 0 )
+  {
+    CPU_CRITICAL_EXIT();
+    return FALSE;
+  }
+  memcpy( sample, hsStream.data[hsStream.head], sizeof(TransferBuffer_Copy) );
+  pkt->counter = hsStream.sequence[hsStream.head];
+  gap = hsStream.gap;
+  hsStream.gap = 0;
+  hsStream.head = (hsStream.head + 1) % HS_STREAM_SLOTS;
+  hsStream.count--;
+  CPU_CRITICAL_EXIT();
+  
+  //a lost packet breaks the delta chain at the tower until the next raw packet
+  if( TransferBuffer_StreamCodec && hsStream.sinceKey < HS_STREAM_KEY_INTERVAL )
+  {
+    start = T0TC; //OS tick timer, counts PCLK and resets every tick
+    len = encodeHSDelta( sample, hsStream.reference, &rxBuffer[2], sizeof(TransferBuffer_Copy) - 2 );
+    stop = T0TC;
+    if( stop < start )
+      stop += T0MR0;
+    stop = (stop - start) * (BSP_CPU_ClkFreq() / BSP_CPU_PclkFreq());
+    if( stop > TransferBuffer_StreamEncodeCycles )
+      TransferBuffer_StreamEncodeCycles = (stop > 0xFFFF) ? 0xFFFF : (UNS16)stop;
+  }
+  
+  if( len )
+  {
+    rxBuffer[0] = gap;
+    rxBuffer[1] = hsStream.referenceSeq;
+    len += 2;
+    pkt->protoCtrl = PKT_PC_HS_STREAM_DELTA;
+    hsStream.sinceKey++;
+  }
+  else
+  {
+    memcpy( rxBuffer, sample, sizeof(TransferBuffer_Copy) );
+    rxBuffer[ sizeof(TransferBuffer_Copy) ] = gap;
+    len = sizeof(TransferBuffer_Copy) + 1;
+    pkt->protoCtrl = PKT_PC_HS_STREAM;
+    hsStream.sinceKey = 0;
+  }
+  memcpy( hsStream.reference, sample, sizeof(TransferBuffer_Copy) );
+  hsStream.referenceSeq = pkt->counter;
+  
+  pkt->networkId = 1;
+  pkt->nodeId = getNodeId(&ObjDict_Data);
+  pkt->lbIndex = 0x53;
+  pkt->hbIndex = 0x20;
+  pkt->subIndex = 3;
+  sendRadioResponse( pkt, rxBuffer, len );
+  TransferBuffer_StreamSent++;
+  TransferBuffer_StreamBytes += len;
+  return TRUE;
+}
+
+//Codes the HS buffer as HS_STREAM_CHANNELS 16 bit channels (LSB first): each channel's difference from the same 
+//channel in reference, zig-zag mapped ((d << 1) ^ (d >> 15)) so small negative steps stay small, then written 
+//7 bits per byte, least significant group first, BIT7 set on all but the last byte of a channel.
+//Returns the coded length, or 0 if it would exceed maxLen.
+static CPU_INT08U encodeHSDelta( const CPU_INT08U *sample, const CPU_INT08U *reference, CPU_INT08U *out, CPU_INT08U maxLen )
+{
+  CPU_INT08U i, len = 0;
+  CPU_INT16S delta;
+  CPU_INT16U code;
+  
+  for( i = 0; i < 2*HS_STREAM_CHANNELS; i += 2 )
+  {
+    delta = (CPU_INT16S)( (sample[i] | (sample[i+1] << 8)) - (reference[i] | (reference[i+1] << 8)) );
+    code = (CPU_INT16U)( (delta << 1) ^ (delta >> 15) );
+    while( code >= 0x80 )
+    {
+      if( len >= maxLen )
+        return 0;
+      out[len++] = (CPU_INT08U)code | 0x80;
+      code >>= 7;
+    }
+    if( len >= maxLen )
+      return 0;
+    out[len++] = (CPU_INT08U)code;
+  }
+  return len;
+}
+
 //----------------------------------------
 void sendRadioResponse( PACKET_HEADER *txPkt, CPU_INT08U *data, CPU_INT08U dataLen )
 {
@@ -637,6 +1381,198 @@ void sendRadioResponse( PACKET_HEADER *txPkt, CPU_INT08U *data, CPU_INT08U dataL
         enableRadioReceiver(); 
 }
 
+//Batched OD read (PKT_PC_BATCH_READ, see gateway.h). Items for the PM are read with GetLocalOD, items for other 
+//nodes through the CAN gateway. Up to BATCH_READ_PARALLEL remote reads to different nodes are begun together, 
+//then collected in order. Results are packed in request order, starting a new response packet when the next 
+//result does not fit; all but the last packet have PKT_PC_MULTI_PKT set. Radio task only.
+static void runBatchRead( PACKET_HEADER *pkt )
+{
+  CPU_INT08U items[ MAX_GTWY_PKT_DATA ];
+  CPU_INT32U result[ BATCH_READ_PARALLEL ][ (MAX_DATA_BUFFER + 2 + 3)/4 ]; //word aligned for GetLocalOD
+  CPU_INT08U resultLen[ BATCH_READ_PARALLEL ], resultStatus[ BATCH_READ_PARALLEL ];
+  GATEWAY_CONTEXT *ctx[ BATCH_READ_PARALLEL ];
+  PACKET_HEADER itemPkt;
+  CPU_INT08U nItems, next, wave, first, i, j, outLen;
+  CPU_INT08U *item;
+  
+  nItems = pkt->dataLen / 4;
+  if( nItems == 0 || nItems > BATCH_READ_MAX_ITEMS || (pkt->dataLen % 4) )
+  {
+    rxBuffer[0] = PKT_EC_ILLEGAL_ADDRESS;
+    pkt->nodeId |= 0x80;
+    sendRadioResponse( pkt, rxBuffer, 1 );
+    return;
+  }
+  memcpy( items, &pkt->data, pkt->dataLen ); //response is built over the request
+  
+  first = 0;   //first item in the current response packet
+  outLen = 0;
+  next = 0;
+  while( next < nItems )
+  {
+    //begin a wave: stop early at a second request to the same remote node, it must wait for the first
+    for( wave = 0; wave < BATCH_READ_PARALLEL && next + wave < nItems; wave++ )
+    {
+      item = &items[ (next + wave)*4 ];
+      for( j = 0; j < wave; j++ )
+      {
+        if( ctx[j] && ctx[j]->nodeId == item[0] )
+          break;
+      }
+      if( j < wave )
+        break;
+      
+      itemPkt.protoCtrl = 0x24;
+      itemPkt.networkId = 1;
+      itemPkt.nodeId    = item[0];
+      itemPkt.lbIndex   = item[1];
+      itemPkt.hbIndex   = item[2];
+      itemPkt.subIndex  = item[3];
+      itemPkt.dataLen   = 0;
+      ctx[wave] = 0;
+      
+      if( item[0] == getNodeId(&ObjDict_Data) )
+      {
+        resultLen[wave] = 4;
+        GetLocalOD( &itemPkt, (CPU_INT08U *)result[wave], &resultLen[wave] );
+        resultStatus[wave] = (itemPkt.nodeId & 0x80) ? BATCH_ITEM_ABORT : BATCH_ITEM_OK;
+      }
+      else if( item[0] == 0 || item[0] > 0x7F )
+      {
+        result[wave][0] = SDOABT_GENERAL_ERROR; //LSB first
+        resultLen[wave] = 4;
+        resultStatus[wave] = BATCH_ITEM_ABORT;
+      }
+      else
+      {
+        ctx[wave] = beginCANGateway( &itemPkt, (CPU_INT08U *)result[wave] );
+      }
+    }
+    
+    for( i = 0; i < wave; i++ )
+    {
+      if( ctx[i] )
+      {
+        resultStatus[i] = endCANGateway( ctx[i], &resultLen[i] ) ? BATCH_ITEM_ABORT : BATCH_ITEM_OK;
+      }
+      if( resultLen[i] > MAX_GTWY_PKT_DATA - 2 ) //value does not fit in any packet, use a single read
+      {
+        result[i][0] = SDOABT_OUT_OF_MEMORY;
+        resultLen[i] = 4;
+        resultStatus[i] = BATCH_ITEM_ABORT;
+      }
+      
+      if( outLen + 2 + resultLen[i] > MAX_GTWY_PKT_DATA )
+      {
+        //send what is packed so far, more follows
+        pkt->protoCtrl = PKT_PC_BATCH_READ | PKT_PC_MULTI_PKT;
+        pkt->subIndex = first;
+        pkt->dataLen = outLen;
+        memcpy( &pkt->data, rxBuffer, outLen );
+        sendRadioPacket( remoteAddress, (CPU_INT08U *)pkt, outLen + 8 );
+        first = next + i;
+        outLen = 0;
+      }
+      rxBuffer[outLen++] = resultStatus[i];
+      rxBuffer[outLen++] = resultLen[i];
+      memcpy( &rxBuffer[outLen], result[i], resultLen[i] );
+      outLen += resultLen[i];
+    }
+    next += wave;
+  }
+  
+  pkt->protoCtrl = PKT_PC_BATCH_READ;
+  pkt->subIndex = first;
+  sendRadioResponse( pkt, rxBuffer, outLen );
+}
+
+//Windowed file upload (PKT_FILE_WINDOW_READ, see gateway.h). Sends every fragment of the window the tower has not 
+//acknowledged, back to back; the next request slides the window. Radio task only.
+static void runWindowedFileRead( PACKET_HEADER *pkt )
+{
+  static CPU_INT08U lastFile = 0;
+  static CPU_INT32U lastEnd = 0; //end of the highest fragment sent for lastFile, anything below was sent before
+  CPU_INT08U *data = &pkt->data;
+  CPU_INT08U fileID = pkt->counter & 0x0F;
+  CPU_INT32U address, fragAddress;
+  CPU_INT08U fragSize, window, i, last, status = 0;
+  CPU_INT16U ackMask;
+  
+  address = data[0] + (data[1]<<8) + (data[2]<<16) + (data[3]<<24);
+  fragSize = data[4];
+  window = data[5];
+  ackMask = data[6] + (data[7]<<8);
+  
+  if( fileID == 0 || fileID > MAX_NUM_FILES )
+  {
+    status = 1;
+  }
+  else if( pkt->dataLen != 8 || fragSize == 0 || fragSize > FILE_WINDOW_FRAG_MAX || window == 0 
+     || window > RADIO_Window_Size || window > FILE_WINDOW_MAX )
+  {
+    status = 2;
+  }
+  else
+  {
+    //last fragment to send, for PKT_PC_MULTI_PKT
+    for( last = window; last > 0 && (ackMask & (1 << (last - 1))); last-- )
+    {
+    }
+    if( fileID != lastFile || (address == 0 && ackMask == 0) ) //new upload
+    {
+      lastFile = fileID;
+      lastEnd = 0;
+    }
+    
+    for( i = 0; i < last; i++ )
+    {
+      if( ackMask & (1 << i) )
+        continue;
+      
+      fragAddress = address + (CPU_INT32U)i * fragSize;
+      status = ReadFileFragment( fileID, fragAddress, rxBuffer, fragSize );
+      if( status )
+      {
+        status |= 0x80;
+        break;
+      }
+      
+      RADIO_Window_Fragments++;
+      if( fragAddress < lastEnd )
+        RADIO_Window_Resent++;
+      else
+        lastEnd = fragAddress + fragSize;
+      
+      pkt->subIndex = i;
+      if( i + 1 < last )
+      {
+        pkt->protoCtrl = 0x26 | PKT_PC_MULTI_PKT;
+        pkt->dataLen = fragSize;
+        memcpy( &pkt->data, rxBuffer, fragSize );
+        sendRadioPacket( remoteAddress, (CPU_INT08U *)pkt, fragSize + 8 );
+      }
+      else
+      {
+        pkt->protoCtrl = 0x26;
+        sendRadioResponse( pkt, rxBuffer, fragSize );
+        return;
+      }
+    }
+    if( status == 0 ) //whole window acknowledged
+    {
+      pkt->protoCtrl = 0x26;
+      pkt->subIndex = window;
+      sendRadioResponse( pkt, rxBuffer, 0 );
+      return;
+    }
+  }
+  
+  pkt->protoCtrl = 0x26;
+  pkt->nodeId |= 0x80;
+  rxBuffer[0] = status;
+  sendRadioResponse( pkt, rxBuffer, 1 );
+}
+
 CPU_INT08U GetLocalOD( PACKET_HEADER * pkt, CPU_INT08U * varData, CPU_INT08U *dataLen )
 {
 	// read local OD data to *data; send data len.
@@ -742,139 +1678,73 @@ CPU_INT08U SetLocalOD( PACKET_HEADER *pkt, CPU_INT08U *data, CPU_INT08U *dataLen
 	return status;
 }
 
+//Error response of GetBlockOD/SetBlockOD: abort code (LSB first) followed by the subindex that failed
+static void setBlockAbort( PACKET_HEADER *pkt, CPU_INT08U *data, CPU_INT08U *rxLen, UNS32 abortCode, UNS8 failedSub )
+{
+  data[0] = (CPU_INT08U)abortCode;
+  data[1] = (CPU_INT08U)(abortCode >> 8);
+  data[2] = (CPU_INT08U)(abortCode >> 16);
+  data[3] = (CPU_INT08U)(abortCode >> 24);
+  data[4] = failedSub;
+  *rxLen = 5;
+  pkt->nodeId |= 0x80;
+}
+
 CPU_INT08U GetBlockOD( PACKET_HEADER *pkt, CPU_INT08U * data, CPU_INT08U *rxLen )
 {
-	// read local OD data to *data; send data len.
-	// return 1=done normal, 2=data is abortcode.
+	// read pkt->dataLen local OD subindexes starting at pkt->subIndex, packed to *data; send data len.
+	// Every type is packed at its OD size, a visible string ends after its null terminator.
+	// return 1=done normal, 2=data is abortcode + failing subindex.
 
   UNS16 Index;
-  UNS8 Subindex;
   UNS32 abortCode;
-  UNS8 checkAccess = 0;
-  UNS8 type;
-  UNS32 varsize = 0;
-  CPU_INT08U status = 0;
-  CPU_INT08U tempData[4];
-  CPU_INT08U * tData = 0;
+  UNS32 size = MAX_GTWY_PKT_DATA;
+  UNS8 failedSub;
   
   Index= pkt->lbIndex + (256 * pkt->hbIndex);
-  Subindex = pkt->subIndex;
-  
-  // get the address of data to start
-  tData = data;
-  
-  memset(data, 0, MAX_GTWY_PKT_DATA);  // clear data
   
-  for (int i = 0; i < (pkt->dataLen); i++)
+  //one index lookup for the whole block
+  abortCode = readLocalDictBlock( &ObjDict_Data, Index, pkt->subIndex, pkt->dataLen, data, &size, 0, &failedSub );
+  if( abortCode != OD_SUCCESSFUL )
   {
-    varsize = 0;
-    type = 0;
-    
-    abortCode = readLocalDict( &ObjDict_Data, Index, Subindex + i, tempData, \
-                         &varsize, &type, checkAccess );
-    
-     if( abortCode != OD_SUCCESSFUL) // check for overrun
-      {
-        *(CPU_INT32U *)data = abortCode ;
-	varsize = 4;
-  	pkt->nodeId |= 0x80;
-	status = 2;
-        break;
-      }
-     switch (type)
-           {
-            case 1: // boolean
-            case 2: // int8
-            case 5: // uns8
-              *data = tempData[0];  
-              data++;
-              break; 
-                           
-            case 3: // int16
-            case 6: // uns16
-              memcpy(data, tempData, 2);
-              data+=2;        
-              break;
-              
-            case 4: // int32
-            case 7: // uns32
-              memcpy(data, tempData, 4);
-              *data =     tempData[0];
-              data+=4;
-              break;
-           default:
-             {
-               break; // no string support
-             }
-           
-           }
-         
-     memset(tempData, 0, sizeof(tempData));
-     status = 1;
-  }
- if ((data - tData) <= MAX_DATA_BUFFER)
-  {
-    *rxLen = data - tData; 
-  }
-  else 
-  {
-    *rxLen = 1;
-    status = 3;
+    setBlockAbort( pkt, data, rxLen, abortCode, failedSub );
+    return 2;
   }
-  return status;
+  
+  *rxLen = (CPU_INT08U)size; 
+  return 1;
 }
 
 CPU_INT08U SetBlockOD( PACKET_HEADER *pkt, CPU_INT08U * data, CPU_INT08U *rxLen )
 {
 	// set local OD data to *data; 
-	// return 1=done normal, 2=data is abortcode.
+	// pkt->dataLen: number of subindexes in the low 6 bits, bytes per value in the top two bits: 0=1, 1=2, 2=4,
+	// 3=each value at the OD size of its subindex (strings, arrays).  Values are packed after the header.
+	// return 1=done normal, 2=data is abortcode + failing subindex.
 
   UNS16 Index;
-  UNS8 Subindex;
   UNS32 abortCode;
-  UNS8 checkAccess = 1;
-  UNS32 varsize = 0;
-  CPU_INT08U status = 0;
-  CPU_INT08U tempData[4];
-  
-  Index= pkt->lbIndex + (256 * pkt->hbIndex);
-  Subindex = pkt->subIndex;
-  
+  UNS8 failedSub;
   UNS8 nSubindices = pkt->dataLen & 0x3F;
-  varsize = 1 << ((pkt->dataLen & 0xC0) >> 6 );  //nbytes specified in top two bits: 0=1, 1=2, 2=4, 3=8(unused)
+  UNS8 sizeCode = (pkt->dataLen & 0xC0) >> 6;
+  UNS8 varsize = (sizeCode == 3) ? 0 : 1 << sizeCode;
   
-  if (varsize == 8)
-    return 2;
-    
-  // get the address of data to start
-  CPU_INT08U * pData = &pkt->data;
+  Index= pkt->lbIndex + (256 * pkt->hbIndex);
   
   //initialize non-error response
   *rxLen = 1;
   *data = 0;
   
-  for (int i = 0; i < nSubindices; i++)
+  //one index lookup for the whole block; the packet payload bounds the source data
+  abortCode = writeLocalDictBlock( &ObjDict_Data, Index, pkt->subIndex, nSubindices, varsize, &pkt->data, 
+                                   MAX_RADIO_BUFFER - 2 - SIZE_PACKET_HEADER, 1, &failedSub ); 
+  if( abortCode != OD_SUCCESSFUL )
   {
-   
-      memcpy(tempData, pData, varsize);
-      pData+=varsize;
-
-    
-      abortCode = writeLocalDict( &ObjDict_Data, Index, Subindex + i, tempData, &varsize, checkAccess ); 
-     if( abortCode != OD_SUCCESSFUL ) // check for overrun
-     {
-	*(CPU_INT32U *)data = abortCode ;
-	*rxLen = 4;
-  	pkt->nodeId |= 0x80;
-        status = 2;
-        break;
-     }
-
-     memset(tempData, 0, sizeof(tempData)); //reset tempData
-     status = 1;
+    setBlockAbort( pkt, data, rxLen, abortCode, failedSub );
+    return 2;
   }
-   
-  return status;
+  
+  return 1;
 }
 
 void processNetworkID0( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer, CPU_INT08U *rxLen )
@@ -37,6 +37,9 @@
                                   //should be at least greater of (Bootloader read buffer length) 256/8 = 8.
                                   //and SDO_MAX_LENGTH_TRANSFER/8
 #define RADIO_POLL_INTERVAL                     5
+#define GATEWAY_MAX_CONTEXTS   SDO_MAX_SIMULTANEOUS_TRANSFERS //concurrent SDO requests, users listed at gatewayPool in gateway.c
+#define GATEWAY_CACHE_ENTRIES      4  //remote OD reads kept by the gateway, see gatewayCacheTTL in gateway.c (16 bytes of RAM each)
+#define GATEWAY_CACHE_VALUE_SIZE   4  //larger values are not cached
 
 typedef __packed struct 
 {
@@ -68,16 +71,61 @@ typedef __packed struct
 
 #define MAX_GTWY_PKT_DATA			50
 
+/* Batched OD read (protoCtrl PKT_PC_BATCH_READ, addressed to the PM node)
+   request data:  (nodeId, lbIndex, hbIndex, subIndex) per item, nodeId may be the PM or any CAN node
+   response data: (status, len, value[len]) per item in request order, status BATCH_ITEM_ABORT carries the 
+                  4 byte abort code (LSB first).  If the results do not fit in one packet, every packet but the 
+                  last has PKT_PC_MULTI_PKT set; subIndex holds the number of the first item in each packet */
+#define PKT_PC_BATCH_READ			0x28
+#define BATCH_READ_MAX_ITEMS			(MAX_GTWY_PKT_DATA / 4)
+#define BATCH_READ_PARALLEL			2  //remote reads to different nodes in flight at once (< GATEWAY_MAX_CONTEXTS)
+#define BATCH_ITEM_OK				0
+#define BATCH_ITEM_ABORT			1
+
+/* High speed data stream packet (protoCtrl PKT_PC_HS_STREAM), pushed without request while TransferBuffer_StreamMode 
+   is set.  counter: sequence number (TransferBuffer_RadioCounter when the buffer was filled), index/subIndex: 0x2053.3
+   data: the 48 byte HS buffer followed by the number of buffers dropped just before this one (gap, saturates at 255) */
+#define PKT_PC_HS_STREAM			0x2A
+#define HS_STREAM_SLOTS				2  //buffers queued for the radio task (49 bytes of RAM each)
+
+/* Delta coded high speed data stream packet (protoCtrl PKT_PC_HS_STREAM_DELTA), sent instead of PKT_PC_HS_STREAM 
+   when TransferBuffer_StreamCodec is set and the coded buffer is smaller than the raw one.  counter and index as above.
+   data: gap, sequence number of the reference buffer (the last buffer sent), then one zig-zag varint per 16 bit 
+   channel (HS_STREAM_CHANNELS, see encodeHSDelta in gateway.c).  To decode, the tower needs the reference buffer: 
+   channel = reference channel + ((code >> 1) ^ -(code & 1)), modulo 2^16.  If the reference was not received the 
+   packet is discarded; a raw packet is sent at least every HS_STREAM_KEY_INTERVAL + 1 packets to resynchronize */
+#define PKT_PC_HS_STREAM_DELTA			0x2C
+#define HS_STREAM_CHANNELS			24  //48 byte HS buffer as 16 bit samples
+#define HS_STREAM_KEY_INTERVAL			15
+
+/* Windowed file upload (protoCtrl 0x26, counter = (PKT_FILE_WINDOW_READ << 4) | fileID)
+   request data:  address (4 bytes, LSB first), fragment size (1 to FILE_WINDOW_FRAG_MAX), window (1 to RADIO_Window_Size),
+                  acknowledge mask (2 bytes, LSB first, bit i set: fragment i already received)
+   response:      one packet per fragment not acknowledged, sent back to back, subIndex = fragment number, data = the 
+                  fragment read at address + subIndex * fragment size.  All but the last have PKT_PC_MULTI_PKT set.
+   The tower slides the window to its first missing fragment and acknowledges the ones it holds beyond it, so lost
+   fragments are the only ones sent again.  Errors: nodeId | 0x80, data = 1 (bad file), 2 (bad size/window), 
+   0x80 + flash error */
+#define PKT_FILE_WINDOW_READ			0xC
+#define FILE_WINDOW_MAX				16  //acknowledge mask bits
+#define FILE_WINDOW_FRAG_MAX			MAX_GTWY_PKT_DATA
+
 /**************Data ***********************************/
 
 extern const CPU_INT08U CT_NODE_ADDRESS;
-extern OS_SEM GatewayAccessControl;
+extern OS_MUTEX GatewayAccessControl;
 
 // -------- PROTOTYPES ----------
 
-void processCANGateway( void );
-void updateCANGatewayState( void );
-void initCANGateway( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer );
+void InitCANGateway( void );
+void processCANGateway( CPU_INT08U nodeId );
+CPU_BOOLEAN completeCANGatewayFastSDO( CPU_INT16U cobId, const CPU_INT08U *data );
+void InvalidateCANGatewayCache( CPU_INT08U nodeId );
+CPU_BOOLEAN QueueHSStream( const CPU_INT08U *data, CPU_INT08U sequence );
+void WakeHSStream( void );
+void ResetHSStream( void );
+void LockSDOLines( void );
+void UnlockSDOLines( void );
 CPU_INT08U runCANGateway(PACKET_HEADER *pkt, CPU_INT08U *rxBuffer, CPU_INT08U *rxLenPtr); 
 //CPU_INT08U putCanPacket( PACKET_HEADER *pkt, CPU_INT08U *rxBuffer );
 //CPU_INT08U getCanPacket( CPU_INT08U *rxLen );
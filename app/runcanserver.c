@@ -42,8 +42,32 @@
 
 
 // --------  Static DATA   ------------
-// canOpen
-static Message m = Message_Initializer;
+
+// OD variables refreshed by RunIOScanTask, their writers mark them for the send-on-change TPDOs when the value changed.
+// TPDOs mapping other directly written variables (e.g. BatteryControl_LowPowerStatus, set by several tasks)
+// fall back to rebuilding and comparing on every event.
+static const s_TPDO_marked_object ioScanODVars[] =
+{
+  { &Temperature, sizeof(Temperature) },
+  { &Status_TemperatureCount, sizeof(Status_TemperatureCount) },
+  { AccelerometersPM, sizeof(AccelerometersPM) },
+  { ChargingData, sizeof(ChargingData) },
+  { Battery1Charge_Status, sizeof(Battery1Charge_Status) },
+  { Battery2Charge_Status, sizeof(Battery2Charge_Status) },
+  { Battery3Charge_Status, sizeof(Battery3Charge_Status) },
+  { &BatteryControl_VREC, sizeof(BatteryControl_VREC) },
+  { &BatteryControl_VSYS, sizeof(BatteryControl_VSYS) },
+  { &BatteryControl_VNET, sizeof(BatteryControl_VNET) },
+  { &BatteryControl_LOAD, sizeof(BatteryControl_LOAD) },
+  { &BatteryControl_RequestedChargingCurrent, sizeof(BatteryControl_RequestedChargingCurrent) },
+  { &BatteryControl_CommandedChargingCurrent, sizeof(BatteryControl_CommandedChargingCurrent) },
+  { &BatteryControl_BatteryChargeRun, sizeof(BatteryControl_BatteryChargeRun) },
+  { &NetworkPowerControl, sizeof(NetworkPowerControl) },
+  { &NetworkVoltage, sizeof(NetworkVoltage) },
+  { &CAN_EnabledInterrupts, sizeof(CAN_EnabledInterrupts) },
+  { &Status_RemoteFlashBlock, sizeof(Status_RemoteFlashBlock) },
+  { &Status_NV_Flash_Status, sizeof(Status_NV_Flash_Status) }
+};
 
 
 /******************************************/
@@ -57,6 +81,7 @@ unsigned char nodeID= 7;
 UNS16 n = 0;
 
 OS_SEM CanTimerSem;
+OS_SEM CanRxSem;
 OS_SEM SleepSem;
 
 
@@ -93,21 +118,28 @@ void InitCANServerTask( void )
 */
 void RunCANServerTask(void)
 {
+    CPU_TS ts;
+    OS_ERR err;
+    Message *rx;
+    UNS8 batch;
      
     /* task loop */
      while(DEF_TRUE)
     {
-      /*Note: canReceive may be called while the CAN peripheral is disabled, as long as 
-      canInit() has been called before this task is created.  
-      The current task will only continue once CAN is enabled and a CAN message is received*/
+      /*Note: the task only continues once CAN is enabled and the RX ISR posts CanRxSem, 
+      which it does when it puts a frame into an empty receive ring*/
+      OSSemPend(&CanRxSem, 0, OS_OPT_PEND_BLOCKING, &ts, &err);
 
-      if (canReceive( &m )) 	 	
+      /* drain the ring, each frame is dispatched in place and then released to the ISR */
+      batch = 0;
+      while ((rx = canReceiveNext()) != NULL)
       {
-			             
-        canDispatch( &ObjDict_Data, &m );	     
+        canDispatch( &ObjDict_Data, rx );
+        canReceiveDone();
+        batch++;
       }
-      
-      
+      if (batch > CAN_Receive_MaxBatch)
+        CAN_Receive_MaxBatch = batch;
     }
     
 }
@@ -203,6 +235,7 @@ void InitIOScanTask(void)
    
    initCaseThermometer();
    
+   SetTPDOMarkedObjects(ioScanODVars, sizeof(ioScanODVars)/sizeof(ioScanODVars[0]));
 }
 
 /**
@@ -217,6 +250,8 @@ void RunIOScanTask(void)
   static CPU_BOOLEAN eraseAllFlag = FALSE;
   static CPU_INT08U flashEraseStopValue = 0;
   UINT32 address;
+  UNS16 remoteFlashBlock, nvFlashStatus;
+  CPU_INT16U enabledInterrupts;
   
   while(DEF_TRUE)
   {
@@ -322,7 +357,12 @@ void RunIOScanTask(void)
     }
 
     // check for error conditions on CAN1       
-    CAN_EnabledInterrupts = (CPU_INT16U)(LPC21XX_CAN_C1IER & 0xFFFF);      
+    enabledInterrupts = (CPU_INT16U)(LPC21XX_CAN_C1IER & 0xFFFF);      
+    if (CAN_EnabledInterrupts != enabledInterrupts)
+    {
+      CAN_EnabledInterrupts = enabledInterrupts;
+      MarkTPDOChanged(&CAN_EnabledInterrupts, sizeof(CAN_EnabledInterrupts));
+    }
     
     CPU_INT08U tempVar = Status_modeSelect & 0xFF;
     Status_modeSelect = 0;
@@ -340,6 +380,8 @@ void RunIOScanTask(void)
        lowBatCounter = 0;
     
     // erase remote flash - one block per scan
+    remoteFlashBlock = Status_RemoteFlashBlock;
+    nvFlashStatus = Status_NV_Flash_Status;
    
     if (Status_RemoteFlashBlock == 0xFFFF || Status_RemoteFlashBlock == 0xFFFE || eraseAllFlag)
     {     
@@ -388,6 +430,11 @@ void RunIOScanTask(void)
       eraseAllFlag = FALSE;
       Status_RemoteFlashBlock = 0;
     }
+    
+    if (Status_RemoteFlashBlock != remoteFlashBlock)
+      MarkTPDOChanged(&Status_RemoteFlashBlock, sizeof(Status_RemoteFlashBlock));
+    if (Status_NV_Flash_Status != nvFlashStatus)
+      MarkTPDOChanged(&Status_NV_Flash_Status, sizeof(Status_NV_Flash_Status));
 
   }
   
@@ -481,6 +528,7 @@ void UpdateBatteryODValues()
     
     ChargingData[19] = (UINT8) (AvgCurrent>>8); //HB
     ChargingData[18] = (UINT8) AvgCurrent;      //LB
+    MarkTPDOChanged(ChargingData, sizeof(ChargingData)); //BatteryUpdateCounter changes on every call
    
 //    //Maximum NAC and LMD is 2048mAh = 20,480.  INT16 is sufficient
 //    //NAC and LMD are in 0.1 mAh.  Capacity is in %.
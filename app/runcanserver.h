@@ -36,6 +36,7 @@ void LowPowerBatteryThermScan();
 //void LowPowerChargingExit();
 
 extern OS_SEM CanTimerSem;
+extern OS_SEM CanRxSem;
 extern OS_SEM SleepSem;
 
 extern void setTaskStackUsage(void);
@@ -29,6 +29,8 @@
 
 
 #define NV_BIN_PAGE_SIZE		512
+#define SCRIPT_PENDING_ROUND_ROBIN      BIT31 //round robin request bit in scriptLanePendingBitmap
+#define SCRIPT_STAT_COUNT(count)        do { if ((count) < 0xFF) (count)++; } while (0) //saturating ScriptStats_Trigger count
 /*******************************************************************************************************
 *                                         Globals
 ********************************************************************************************************/
@@ -42,6 +44,31 @@ CPU_INT08U commandByte = 0;
 
 CPU_INT08U scriptInit = FALSE;
 
+//RAM copy of the OD 0x1F51 control words (1 based, entry 0 unused), kept current by OnScriptControlUpdate()
+CPU_INT32U scriptControlWord[MAX_NUMBER_SCRIPTS + 1];
+volatile CPU_INT32U scriptActiveBitmap = 0; //SCRIPT_BIT(n) set: script n has an ID and RUN or RUNONCE set
+volatile CPU_INT32U scriptLoadedBitmap = 0; //SCRIPT_BIT(n) set: script n has an ID
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+volatile CPU_INT32U scriptBackgroundBitmap = 0; //SCRIPT_BIT(n) set: script n runs in the background lane
+
+static OS_SEM * const scriptLaneSem[NUMBER_SCRIPT_LANES] = { &ScriptScheduler_Sem, &ScriptSchedulerBackground_Sem };
+#else
+static OS_SEM * const scriptLaneSem[NUMBER_SCRIPT_LANES] = { &ScriptScheduler_Sem };
+#endif
+static CPU_INT08U scriptLanePending = 0; //bit per lane, set while the lane task is pending on its semaphore
+
+//Pending requests per lane. A script (or the round robin request) is pending at most once per lane, so 
+//the FIFO below can never hold more than MAX_NUMBER_SCRIPTS + 1 entries. All access is inside a critical section.
+static CPU_INT32U scriptLanePendingBitmap[NUMBER_SCRIPT_LANES];  //SCRIPT_BIT(n) or SCRIPT_PENDING_ROUND_ROBIN
+static CPU_INT08U scriptPendingOrder[NUMBER_SCRIPT_LANES][MAX_NUMBER_SCRIPTS + 1]; //trigger order
+static CPU_INT08U scriptPendingHead[NUMBER_SCRIPT_LANES];
+static CPU_INT08U scriptPendingCount[NUMBER_SCRIPT_LANES];
+static CPU_INT32U scriptTriggerTime[MAX_NUMBER_SCRIPTS + 1]; //Timer1 count of the trigger that made the script pending
+static CPU_INT08U scriptOverrunEmcyPtr = 0; //script that raised SCRIPT_EMCY_OVERRUN, 0 if not active
+
+static UNS32 OnScriptControlUpdate(CO_Data* d, const indextable * odEntry, UNS8 bSubindex);
+static UNS32 OnScriptScanControlUpdate(CO_Data* d, const indextable * odEntry, UNS8 bSubindex);
+
 /*
 *********************************************************************************************************
 *                                             InitScripts()
@@ -56,6 +83,8 @@ CPU_INT08U scriptInit = FALSE;
 */
 void Scripts_Init(void)
 {
+  ScriptControl_Init();
+  RegisterSetODentryCallBack(&ObjDict_Data, 0x1F5A, 27, &OnScriptScanControlUpdate);
   
   if(LoadGlobalVarTable( 0 ))
   {
@@ -77,62 +106,472 @@ void Scripts_Init(void)
   // now run startup script
   if (Control_StartUp_ScriptPointer  > 0 && Control_SystemControl && 0x0100 == 0x0100) // check for valid scriptID
   { 
-      AddScriptToQueue( Control_StartUp_ScriptPointer );
+      AddScriptToQueue( Control_StartUp_ScriptPointer, SCRIPT_TRIGGER_STARTUP );
   }
  }
 
-CPU_INT08U AddScriptToQueue(CPU_INT08U scriptPtr)
+/*
+*********************************************************************************************************
+*                                             ScriptLane_Mask()
+*
+* Description : Returns the bitmap of scripts assigned to a lane (see SCRIPT_CW_BACKGROUND_LANE).
+*
+* Argument(s) : SCRIPT_LANE_CONTROL or SCRIPT_LANE_BACKGROUND
+*
+* Return(s)   : script bitmap.
+*
+*********************************************************************************************************
+*/
+static CPU_INT32U ScriptLane_Mask(CPU_INT08U lane)
+{
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+  if (lane == SCRIPT_LANE_BACKGROUND)
+    return scriptBackgroundBitmap;
+  
+  return ~scriptBackgroundBitmap;
+#else
+  return 0xFFFFFFFF; //single lane
+#endif
+}
+
+/*
+*********************************************************************************************************
+*                                             ScriptLane_Current()
+*
+* Description : Identifies the lane of the calling script task. BasePrio is used so that a lane holding
+*               the gateway mutex (inherited priority) is still identified correctly.
+*
+* Argument(s) : none
+*
+* Return(s)   : SCRIPT_LANE_CONTROL or SCRIPT_LANE_BACKGROUND.
+*
+*********************************************************************************************************
+*/
+CPU_INT08U ScriptLane_Current(void)
+{
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+  if (OSTCBCurPtr->BasePrio == RUNSCRIPT_BG_TASK_PRIO)
+    return SCRIPT_LANE_BACKGROUND;
+#endif
+  
+  return SCRIPT_LANE_CONTROL;
+}
+
+/*
+*********************************************************************************************************
+*                                             AddScriptToLane()
+*
+* Description : Marks a script (or the round robin request) pending in a lane and signals the lane task.
+*               A trigger for a script that is already pending is coalesced into the pending request and 
+*               counted in ScriptStats_Trigger instead of being queued again, so repeated RTC alarms or 
+*               RPDOs can never exhaust the scheduler. Requests are run in the order they first became pending.
+*               May be called from an ISR.
+*
+* Argument(s) : lane; scriptPtr between 1 and MAX_NUMBER_SCRIPTS or ROUND_ROBIN_SCRIPT
+*
+* Return(s)   : 0 if pending (new or coalesced), 4 round robin skipped, 6 OS error.
+*
+*********************************************************************************************************
+*/
+static CPU_INT08U AddScriptToLane(CPU_INT08U lane, CPU_INT08U scriptPtr)
 {
   OS_ERR err;
-  CPU_INT32U varsize = 0;
-  CPU_INT08U type = 0;
-  CPU_INT08U controlWord[4];
-  static CPU_INT08U scriptQ = 0;
+  CPU_INT32U pendingBit;
+  CPU_INT08U tail;
+  CPU_SR_ALLOC();
+  
+  if (scriptPtr == ROUND_ROBIN_SCRIPT)
+    pendingBit = SCRIPT_PENDING_ROUND_ROBIN;
+  else
+    pendingBit = SCRIPT_BIT(scriptPtr);
+  
+  CPU_CRITICAL_ENTER();
+  if (scriptPtr == ROUND_ROBIN_SCRIPT)
+  {
+    //roundrobinscripts won't be queued if the last pass is still pending or there are many scripts waiting
+    if ((scriptLanePendingBitmap[lane] & pendingBit) || scriptPendingCount[lane] >= ROUND_ROBIN_SKIP_QUEUE)
+    {
+      CPU_CRITICAL_EXIT();
+      Status_ScriptSkipCounter++;
+      return 4;
+    }
+  }
+  else if (scriptLanePendingBitmap[lane] & pendingBit)
+  {
+    SCRIPT_STAT_COUNT(ScriptStats_Trigger[scriptPtr - 1][SCRIPT_STAT_COALESCED]);
+    CPU_CRITICAL_EXIT();
+    return 0;
+  }
+  
+  scriptLanePendingBitmap[lane] |= pendingBit;
+  tail = scriptPendingHead[lane] + scriptPendingCount[lane];
+  if (tail > MAX_NUMBER_SCRIPTS)
+    tail -= MAX_NUMBER_SCRIPTS + 1;
+  scriptPendingOrder[lane][tail] = scriptPtr;
+  scriptPendingCount[lane]++;
+  
+  if (scriptPtr != ROUND_ROBIN_SCRIPT)
+    scriptTriggerTime[scriptPtr] = GetTimer1Count();
+  CPU_CRITICAL_EXIT();
+  
+  //trigger Script Task to run next pending script
+  OSSemPost(scriptLaneSem[lane], OS_OPT_POST_1, &err);
+  if (err != OS_ERR_NONE)
+  {
+    //the request stays pending and is picked up on the next post to this lane
+    if (scriptPtr != ROUND_ROBIN_SCRIPT)
+    {
+      CPU_CRITICAL_ENTER();
+      SCRIPT_STAT_COUNT(ScriptStats_Trigger[scriptPtr - 1][SCRIPT_STAT_DROPPED]);
+      CPU_CRITICAL_EXIT();
+    }
+    return 6;
+  }
+  
+  return 0;
+}
 
+/*
+*********************************************************************************************************
+*                                             AddScriptToQueue()
+*
+* Description : Requests a script run from startup, an RPDO, an RTC alarm or the script interval timer.
+*               May be called from an ISR.
+*
+* Argument(s) : scriptPtr between 1 and MAX_NUMBER_SCRIPTS or ROUND_ROBIN_SCRIPT; 
+*               triggerSource SCRIPT_TRIGGER_xxx (counted per script in OD 0x1F59)
+*
+* Return(s)   : 0 if pending, 1 bad pointer, 2 no script ID, 4 round robin skipped, 5 not initialized, 
+*               6 OS error, 7 scripts disabled.
+*
+*********************************************************************************************************
+*/
+CPU_INT08U AddScriptToQueue(CPU_INT08U scriptPtr, CPU_INT08U triggerSource)
+{
+  CPU_INT08U lane;
+  CPU_INT08U laneErr;
+  CPU_INT08U firstErr = 0;
+  CPU_INT08U err = 0;
+  CPU_SR_ALLOC();
   
-  if( !scriptInit )
-    return 5; 
-  if(!(Control_SystemControl & BIT4)) //If scripts are not enabled
-    return 7;
-    
   //RoundRobin Script Pointer will be determined by Script Task
   //Other script pointers should be vaidated here
-  //roundrobinscripts won't be queued if there are not many slots left
   if (scriptPtr == ROUND_ROBIN_SCRIPT)
   {
-    if(ScriptScheduler_Q.MsgQ.NbrEntries >=  ROUND_ROBIN_SKIP_QUEUE)
+    if( !scriptInit )
+      return 5; 
+    if(!(Control_SystemControl & BIT4)) //If scripts are not enabled
+      return 7;
+    
+    //each lane runs its own round robin pass over the scripts assigned to it
+    for (lane = 0; lane < NUMBER_SCRIPT_LANES; lane++)
     {
-      Status_ScriptSkipCounter++;
-      return 4;
+      if (scriptActiveBitmap & ScriptLane_Mask(lane))
+      {
+        laneErr = AddScriptToLane(lane, ROUND_ROBIN_SCRIPT);
+        if (firstErr == 0)
+          firstErr = laneErr;
+      }
     }
+    return firstErr;
   }
-  else  //not a roundRobin Script
+  
+  if (scriptPtr > MAX_NUMBER_SCRIPTS || scriptPtr == 0)
+    return 1; //error: scriptPtr out of expected range
+  
+  if( !scriptInit )
+    err = 5; 
+  else if(!(Control_SystemControl & BIT4)) //If scripts are not enabled
+    err = 7;
+  else if (!(scriptLoadedBitmap & SCRIPT_BIT(scriptPtr))) 
+    err = 2; //error: no scriptID attached to scriptPtr
+  
+  CPU_CRITICAL_ENTER();
+  if (err)
+    SCRIPT_STAT_COUNT(ScriptStats_Trigger[scriptPtr - 1][SCRIPT_STAT_DROPPED]);
+  else if (triggerSource < SCRIPT_TRIGGER_ROUND_ROBIN)
+    SCRIPT_STAT_COUNT(ScriptStats_Trigger[scriptPtr - 1][triggerSource]);
+  CPU_CRITICAL_EXIT();
+  
+  if (err)
+    return err;
+  
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+  if (scriptBackgroundBitmap & SCRIPT_BIT(scriptPtr))
+    return AddScriptToLane(SCRIPT_LANE_BACKGROUND, scriptPtr);
+#endif
+  
+  return AddScriptToLane(SCRIPT_LANE_CONTROL, scriptPtr);
+}
+
+/*
+*********************************************************************************************************
+*                                             TakePendingScript()
+*
+* Description : Removes the oldest pending request of a lane and records the trigger to start latency.
+*
+* Argument(s) : lane
+*
+* Return(s)   : script pointer, ROUND_ROBIN_SCRIPT, or 0 if nothing is pending.
+*
+*********************************************************************************************************
+*/
+static CPU_INT08U TakePendingScript(CPU_INT08U lane)
+{
+  CPU_INT08U scriptPtr;
+  CPU_INT32U latency;
+  CPU_INT08U *stats;
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  if (scriptPendingCount[lane] == 0)
   {
-    if (scriptPtr > MAX_NUMBER_SCRIPTS || scriptPtr == 0)
-      return 1; //error: scriptPtr out of expected range
-      
-    readLocalDict( &ObjDict_Data, 0x1F51, scriptPtr, controlWord, &varsize, &type, 0);
-    if (controlWord[1] == 0) 
-      return 2; //error: no scriptID attached to scriptPtr
+    CPU_CRITICAL_EXIT();
+    return 0;
+  }
+  
+  scriptPtr = scriptPendingOrder[lane][scriptPendingHead[lane]];
+  if (++scriptPendingHead[lane] > MAX_NUMBER_SCRIPTS)
+    scriptPendingHead[lane] = 0;
+  scriptPendingCount[lane]--;
+  
+  if (scriptPtr == ROUND_ROBIN_SCRIPT)
+  {
+    scriptLanePendingBitmap[lane] &= ~SCRIPT_PENDING_ROUND_ROBIN;
+  }
+  else
+  {
+    scriptLanePendingBitmap[lane] &= ~SCRIPT_BIT(scriptPtr);
+    
+    latency = (GetTimer1Count() - scriptTriggerTime[scriptPtr]) >> SCRIPT_STAT_LATENCY_LOG2; //modulo arithmetic handles rollover
+    if (latency > 0xFF)
+      latency = 0xFF;
+    stats = ScriptStats_Trigger[scriptPtr - 1];
+    stats[SCRIPT_STAT_LAST_LATENCY] = (CPU_INT08U)latency;
+    if (latency > stats[SCRIPT_STAT_MAX_LATENCY])
+      stats[SCRIPT_STAT_MAX_LATENCY] = (CPU_INT08U)latency;
+  }
+  CPU_CRITICAL_EXIT();
+  
+  return scriptPtr;
+}
+
+/*
+*********************************************************************************************************
+*                                             RecordScriptScanTime()
+*
+* Description : Records one interpreter run in the script's entry of OD 0x1F5A and in the shared histogram,
+*               and checks it against ScriptStats_ScanBudget. An overrun optionally raises EMCY SCRIPT_EMCY_OVERRUN, which is 
+*               cleared again the next time the same script runs within budget.
+*
+* Argument(s) : scriptPtr between 1 and MAX_NUMBER_SCRIPTS; scanTime in Timer1 counts
+*
+* Return(s)   : none.
+*
+*********************************************************************************************************
+*/
+static void RecordScriptScanTime(CPU_INT08U scriptPtr, CPU_INT32U scanTime)
+{
+  CPU_INT16U *stats = ScriptStats_ScanTime[scriptPtr - 1];
+  CPU_INT32U bound = (CPU_INT32U)1 << SCRIPT_SCAN_BUCKET0_LOG2;
+  CPU_INT08U bucket = 0;
+  CPU_SR_ALLOC();
+  
+  //no CLZ on the ARM7TDMI, at most SCRIPT_SCAN_BUCKETS - 1 compares
+  while (scanTime >= bound && bucket < SCRIPT_SCAN_BUCKETS - 1)
+  {
+    bound <<= 1;
+    bucket++;
   }
+  CPU_CRITICAL_ENTER(); //the histogram is shared by the lanes
+  if (ScriptStats_ScanHistogram[bucket] < 0xFFFF)
+    ScriptStats_ScanHistogram[bucket]++;
+  CPU_CRITICAL_EXIT();
   
-  scriptQ = scriptPtr;
+  if (scanTime > 0xFFFF)
+    scanTime = 0xFFFF;
+  stats[SCRIPT_SCAN_LAST] = (CPU_INT16U)scanTime;
+  if (scanTime > stats[SCRIPT_SCAN_MAX])
+    stats[SCRIPT_SCAN_MAX] = (CPU_INT16U)scanTime;
+  
+  if (ScriptStats_ScanBudget == 0)
+    return;
+  
+  if (scanTime > ScriptStats_ScanBudget)
+  {
+    if (stats[SCRIPT_SCAN_OVERRUNS] < 0xFFFF)
+      stats[SCRIPT_SCAN_OVERRUNS]++;
+    
+    if ((ScriptStats_ScanControl & SCRIPT_SCAN_CTRL_EMCY) && scriptOverrunEmcyPtr == 0)
+    {
+      scriptOverrunEmcyPtr = scriptPtr;
+      EMCY_setError(&ObjDict_Data, SCRIPT_EMCY_OVERRUN, 0x80, scriptPtr);
+    }
+  }
+  else if (scriptOverrunEmcyPtr == scriptPtr)
+  {
+    scriptOverrunEmcyPtr = 0;
+    EMCY_errorRecovered(&ObjDict_Data, SCRIPT_EMCY_OVERRUN);
+  }
+}
 
-  //trigger Script Task to run next script in queue
-  OSQPost(&ScriptScheduler_Q, &scriptQ, sizeof(scriptQ), OS_OPT_POST_FIFO, &err); 
-  if (err == OS_ERR_MSG_POOL_EMPTY)
+/*
+*********************************************************************************************************
+*                                             OnScriptScanControlUpdate()
+*
+* Description : OD callback for 0x1F5A.1B. SCRIPT_SCAN_CTRL_RESET clears all scan time statistics and
+*               any active overrun EMCY.
+*
+* Argument(s) : standard ODCallback_t arguments
+*
+* Return(s)   : OD_SUCCESSFUL.
+*
+*********************************************************************************************************
+*/
+static UNS32 OnScriptScanControlUpdate(CO_Data* d, const indextable * odEntry, UNS8 bSubindex)
+{
+  if (ScriptStats_ScanControl & SCRIPT_SCAN_CTRL_RESET)
   {
-    return 3; //error: too many scripts queued
+    memset(ScriptStats_ScanTime, 0, sizeof(ScriptStats_ScanTime));
+    memset(ScriptStats_ScanHistogram, 0, sizeof(ScriptStats_ScanHistogram));
+    ScriptStats_ScanControl &= ~SCRIPT_SCAN_CTRL_RESET;
+    
+    if (scriptOverrunEmcyPtr)
+    {
+      scriptOverrunEmcyPtr = 0;
+      EMCY_errorRecovered(d, SCRIPT_EMCY_OVERRUN);
+    }
   }
   
-  if (err != OS_ERR_NONE)
+  return OD_SUCCESSFUL;
+}
+
+/*
+*********************************************************************************************************
+*                                             SetScriptLanePending()
+*
+* Description : Tracks which lanes are waiting for work. BatteryControl_LowPowerStatus BIT5 (script task
+*               pending, checked by SleepTask) is only set when every lane is pending.
+*
+* Argument(s) : lane; isPending
+*
+* Return(s)   : none.
+*
+*********************************************************************************************************
+*/
+static void SetScriptLanePending(CPU_INT08U lane, CPU_BOOLEAN isPending)
+{
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  if (isPending)
+    scriptLanePending |= (1 << lane);
+  else
+    scriptLanePending &= ~(1 << lane);
+  
+  if (scriptLanePending == ((1 << NUMBER_SCRIPT_LANES) - 1))
+    BatteryControl_LowPowerStatus |= BIT5; //all script lanes are pending
+  else
+    BatteryControl_LowPowerStatus &=~ BIT5;
+  CPU_CRITICAL_EXIT();
+}
+
+/*
+*********************************************************************************************************
+*                                             UpdateScriptControlCache()
+*
+* Description : Stores a control word in the RAM table and updates the active and loaded bitmaps. 
+*               Called from the OD callback, which may run in the CAN server task or the script task.
+*
+* Argument(s) : scriptPtr between 1 and MAX_NUMBER_SCRIPTS; controlWord as stored in OD 0x1F51
+*
+* Return(s)   : none.
+*
+*********************************************************************************************************
+*/
+static void UpdateScriptControlCache(CPU_INT08U scriptPtr, CPU_INT32U controlWord)
+{
+  CPU_INT32U scriptBit = SCRIPT_BIT(scriptPtr);
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  scriptControlWord[scriptPtr] = controlWord;
+  
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+  if (controlWord & SCRIPT_CW_BACKGROUND_LANE)
+    scriptBackgroundBitmap |= scriptBit;
+  else
+    scriptBackgroundBitmap &= ~scriptBit;
+#endif
+  
+  if (controlWord & SCRIPT_CW_ID_MASK)
   {
-    return 6;
+    scriptLoadedBitmap |= scriptBit;
+    if (controlWord & SCRIPT_CW_RUN_MASK)
+      scriptActiveBitmap |= scriptBit;
+    else
+      scriptActiveBitmap &= ~scriptBit;
   }
+  else
+  {
+    scriptLoadedBitmap &= ~scriptBit;
+    scriptActiveBitmap &= ~scriptBit;
+  }
+  CPU_CRITICAL_EXIT();
+}
+
+/*
+*********************************************************************************************************
+*                                             OnScriptControlUpdate()
+*
+* Description : OD callback for 0x1F51 subindex 1..MAX_NUMBER_SCRIPTS. Every write through setODentry 
+*               (SDO, radio, scripts) refreshes the RAM copy so the scheduler never has to read the OD.
+*
+* Argument(s) : standard ODCallback_t arguments
+*
+* Return(s)   : OD_SUCCESSFUL.
+*
+*********************************************************************************************************
+*/
+static UNS32 OnScriptControlUpdate(CO_Data* d, const indextable * odEntry, UNS8 bSubindex)
+{
+  if (bSubindex > 0 && bSubindex <= MAX_NUMBER_SCRIPTS)
+    UpdateScriptControlCache(bSubindex, *(UNS32 *)odEntry->pSubindex[bSubindex].pObject);
   
-  return 0;
+  return OD_SUCCESSFUL;
 }
 
+/*
+*********************************************************************************************************
+*                                             ScriptControl_Init()
+*
+* Description : Registers the 0x1F51 write callbacks and loads the RAM copy of the control words.
+*               Must be called after RestoreValues() and before any script is queued.
+*
+* Argument(s) : none
+*
+* Return(s)   : none.
+*
+*********************************************************************************************************
+*/
+void ScriptControl_Init(void)
+{
+  CPU_INT08U i;
+  UNS32 controlWord;
+  UNS32 varsize;
+  UNS8 type;
+  
+  for (i = 1; i <= MAX_NUMBER_SCRIPTS; i++)
+  {
+    RegisterSetODentryCallBack(&ObjDict_Data, 0x1F51, i, &OnScriptControlUpdate);
+    
+    controlWord = 0;
+    varsize = 0;
+    type = 0;
+    readLocalDict( &ObjDict_Data, 0x1F51, i, &controlWord, &varsize, &type, 0);
+    UpdateScriptControlCache(i, controlWord);
+  }
+}
 
  
   /*
@@ -516,33 +955,34 @@ CPU_INT08U LoadGlobalVarTable (CPU_INT08U scriptPointer)
 *
 *               Script execution order can be modified by changing the values in the array 1F56.1
 *
+*               Each lane (control and background, selected by bit 3 of the control word) runs this loop
+*               in its own task, so every lane has its own pending list, round robin position and interpreter
+*               stack frame. The control lane preempts the background lane.
 *              
-* Argument(s) : none
+* Argument(s) : lane - SCRIPT_LANE_CONTROL or SCRIPT_LANE_BACKGROUND
 *
 * Return(s)   : none.
 *
 *********************************************************************************************************
 */
-void RunScriptTask(void)
+static void RunScriptLane(CPU_INT08U lane)
 { 
   UNS32 intervalTime = 0;
   UNS32 getTime = 0;
+  UNS32 runTime = 0;
   //UNS8 subIndexSize = 0;
   //int i,j;
-  UNS8 type = 0;
   UNS32 varsize = 0;
   UNS8 controlWord[4];
   OS_ERR err;
   //UNS32 control = 0;
   UNS8 scriptErr = 0;
-  void *p_msg;
   CPU_INT08U scriptPointer = 0;
   CPU_INT08U childScriptPointer = 0;
   CPU_INT08U childScriptCounter;
-  static CPU_INT08U roundRobinIndex = 0;
+  CPU_INT08U roundRobinIndex = 0;
   CPU_TS ts;
   CPU_BOOLEAN isRoundRobin;
-  OS_MSG_SIZE msg_size;
   
   while ( TRUE ) 
   {
@@ -550,12 +990,12 @@ void RunScriptTask(void)
       
       // wait on Semaphore 
       //Note that this is a counting semaphore and may be nonzero before, 
-      //i.e. several scripts may be queued
-      BatteryControl_LowPowerStatus |= BIT5; //ScriptTask is pending
-      p_msg = OSQPend(&ScriptScheduler_Q, 0, OS_OPT_PEND_BLOCKING, &msg_size, &ts, &err); 
+      //i.e. several scripts may be pending
+      SetScriptLanePending(lane, TRUE); //ScriptTask is pending
+      OSSemPend(scriptLaneSem[lane], 0, OS_OPT_PEND_BLOCKING, &ts, &err); 
       if (err == OS_ERR_NONE)
       {
-        scriptPointer = ((CPU_INT08U*) p_msg)[0];
+        scriptPointer = TakePendingScript(lane);
         if (scriptPointer == 0) 
         {
           asm("nop");
@@ -568,7 +1008,7 @@ void RunScriptTask(void)
         continue;
       }
         
-      BatteryControl_LowPowerStatus &=~ BIT5; //ScriptTask is not pending
+      SetScriptLanePending(lane, FALSE); //ScriptTask is not pending
       
       
         
@@ -583,6 +1023,9 @@ void RunScriptTask(void)
       {
         // Note that ScriptOrder array is zero based but the scriptpointers are one based. 
         //Find next valid scriptPointer that is set to run
+        if ((scriptActiveBitmap & ScriptLane_Mask(lane)) == 0) //nothing in this lane set to RUN or RUNONCE, skip the scan
+          roundRobinIndex = MAX_NUMBER_SCRIPTS;
+        
         while (roundRobinIndex < MAX_NUMBER_SCRIPTS)
         {
           scriptPointer = Script_Order[roundRobinIndex];
@@ -592,14 +1035,9 @@ void RunScriptTask(void)
             roundRobinIndex++;
             continue; //go to next script in RoundRobin
           }
-
-          // get controlWord for script
-          type = 0;
-          varsize = 0;     
-          readLocalDict( &ObjDict_Data, 0x1F51, scriptPointer, controlWord, &varsize, &type, 0);
           
-          //script is not set to RUN or RUNONCE or script has no valid ID attached
-          if ( (controlWord[0] & 0x03) == 0x00 || controlWord[1] == 0)   
+          //script is not set to RUN or RUNONCE, has no valid ID attached or belongs to the other lane
+          if ( !(scriptActiveBitmap & ScriptLane_Mask(lane) & SCRIPT_BIT(scriptPointer)) )   
           {
             roundRobinIndex++;
             continue; //go to next script in RoundRobin
@@ -607,6 +1045,8 @@ void RunScriptTask(void)
           else
           {
             //the script is valid: break from Round Robin while loop and execute script
+            SCRIPT_STAT_COUNT(ScriptStats_Trigger[scriptPointer - 1][SCRIPT_TRIGGER_ROUND_ROBIN]);
+            memcpy(controlWord, &scriptControlWord[scriptPointer], sizeof(controlWord));
             break;
           }
         }
@@ -622,10 +1062,7 @@ void RunScriptTask(void)
       {
         //scriptPointer has  already been verified by AddScriptToQueue  
         //but we still need to initialize controlWord here
-       
-        type = 0;
-        varsize = 0;     
-        readLocalDict( &ObjDict_Data, 0x1F51, scriptPointer, controlWord, &varsize, &type, 0);
+        memcpy(controlWord, &scriptControlWord[scriptPointer], sizeof(controlWord));
       }
            
       //now run main script and child scripts
@@ -640,7 +1077,9 @@ void RunScriptTask(void)
           if(scriptPointer == 0)
             asm("nop");
           
+          runTime = GetTimer1Count();
           scriptErr = RunScriptInterpreter(scriptPointer, &childScriptPointer);
+          RecordScriptScanTime(scriptPointer, GetTimer1Count() - runTime); //modulo arithmetic handles rollover
           
           if(ScriptDebug_Indication & BIT0) {  IO0CLR = BIT1; } //JML DEBUG - See IOInit in app.c for debug usage
         }
@@ -700,13 +1139,28 @@ void RunScriptTask(void)
           // add some bandwidth for other tasks
           OSTimeDlyHMSM(0, 0, 0, 2,  OS_OPT_TIME_HMSM_STRICT, &err); 
       
-          AddScriptToQueue(ROUND_ROBIN_SCRIPT); 
+          if(Control_SystemControl & BIT4) //scripts still enabled
+            AddScriptToLane(lane, ROUND_ROBIN_SCRIPT); 
         }
       }
       
   } //end infinite while
 } // end function
 
+/** @brief Control lane script task: RPDO, RTC alarm and startup triggered control scripts */
+void RunScriptTask(void)
+{
+  RunScriptLane(SCRIPT_LANE_CONTROL);
+}
+
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+/** @brief Background lane script task: scripts with SCRIPT_CW_BACKGROUND_LANE set (logging, string building) */
+void RunScriptBackgroundTask(void)
+{
+  RunScriptLane(SCRIPT_LANE_BACKGROUND);
+}
+#endif
+
 
 
 //bytes 0:1 of script download
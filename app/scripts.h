@@ -20,11 +20,53 @@
 #define LONG_SCRIPT_SIZE                        7680
 #define MAX_NUMBER_SCRIPTS                      25
 #define MAX_NUMBER_CHILD_SCRIPTS                10
-#define MAX_QUEUED_SCRIPTS                      10
 #define ROUND_ROBIN_SKIP_QUEUE                  5 //don't add round robin scripts to queue if there are already 5 scripts queued 
 
 #define ROUND_ROBIN_SCRIPT                      0x80 //must be greater than MAX_NUMBER_SCRIPTS. 
 
+#define SCRIPT_BIT(scriptPtr)                   ((CPU_INT32U)1 << ((scriptPtr) - 1)) //bit for scriptPtr (1 based) in script bitmaps
+#define SCRIPT_CW_RUN_MASK                      0x00000003 //RunOnce | Run continuous
+#define SCRIPT_CW_ID_MASK                       0x0000FF00 //script ID
+#define SCRIPT_CW_BACKGROUND_LANE               0x00000008 //bit 3: run script (and its children) in the background lane (RUNSCRIPT_BG_LANE_EN)
+
+#define SCRIPT_LANE_CONTROL                     0 //RunScriptTask, RUNSCRIPT_TASK_PRIO
+#define SCRIPT_LANE_BACKGROUND                  1 //RunScriptBackgroundTask, RUNSCRIPT_BG_TASK_PRIO
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+#define NUMBER_SCRIPT_LANES                     2
+#else
+#define NUMBER_SCRIPT_LANES                     1
+#endif
+
+//trigger sources passed to AddScriptToQueue(); also the byte offset of the per-source count in ScriptStats_Trigger
+#define SCRIPT_TRIGGER_STARTUP                  0 //startup script
+#define SCRIPT_TRIGGER_RPDO                     1 //RPDO received (0x140x subindex 4)
+#define SCRIPT_TRIGGER_ALARM                    2 //RTC alarm
+#define SCRIPT_TRIGGER_ROUND_ROBIN              3 //script interval timer; counted per script when the round robin pass runs it
+
+//byte offsets in ScriptStats_Trigger[scriptPtr - 1] (OD 0x1F59), counts and latencies saturate at 255
+#define SCRIPT_STAT_COALESCED                   4 //triggers merged into an already pending request
+#define SCRIPT_STAT_DROPPED                     5 //triggers rejected (scripts disabled, no script ID, OS error)
+#define SCRIPT_STAT_LAST_LATENCY                6 //trigger to interpreter start, in 2^SCRIPT_STAT_LATENCY_LOG2 Timer1 counts
+#define SCRIPT_STAT_MAX_LATENCY                 7
+#define SCRIPT_STAT_BYTES                       8
+#define SCRIPT_STAT_LATENCY_LOG2                7 //128 counts (1.024ms), 255 is 261ms or more
+
+//word offsets in ScriptStats_ScanTime[scriptPtr - 1] (OD 0x1F5A), execution time of one interpreter run in Timer1 counts (8us)
+#define SCRIPT_SCAN_LAST                        0 //last execution time (saturated)
+#define SCRIPT_SCAN_MAX                         1 //maximum execution time (saturated)
+#define SCRIPT_SCAN_OVERRUNS                    2 //runs longer than ScriptStats_ScanBudget
+#define SCRIPT_SCAN_WORDS                       3
+
+//ScriptStats_ScanHistogram (OD 0x1F5A.1C), runs of all scripts
+#define SCRIPT_SCAN_BUCKETS                     8 //log2 histogram: bucket 0 < 128 counts (1ms), bucket b < 2^(b+7) counts, bucket 7 >= 8192 counts (65ms)
+#define SCRIPT_SCAN_BUCKET0_LOG2                7
+
+//ScriptStats_ScanControl (OD 0x1F5A.1B) bits
+#define SCRIPT_SCAN_CTRL_EMCY                   BIT0 //raise EMCY SCRIPT_EMCY_OVERRUN when a script exceeds the budget
+#define SCRIPT_SCAN_CTRL_RESET                  BIT7 //write 1 to clear 0x1F5A.1..25 and the histogram, self clearing
+
+#define SCRIPT_EMCY_OVERRUN                     0x6201 //software error; additional info = script pointer
+
 //#define GLOBAL_CONSTANTS_TABLE_ADDRESS          0x0003C800
 #define GLOBAL_VAR_TABLE_SIZE                   400
 
@@ -51,7 +93,14 @@ extern CPU_INT08U targetHSChannel;
 extern CPU_INT08U globalVariables[GLOBAL_VAR_TABLE_SIZE];
 extern CPU_INT16U globalVarOffset[MAX_NUMBER_SCRIPTS + 1];
 extern CPU_INT08U commandByte;
-extern OS_Q ScriptScheduler_Q;
+extern OS_SEM ScriptScheduler_Sem;
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+extern OS_SEM ScriptSchedulerBackground_Sem;
+extern volatile CPU_INT32U scriptBackgroundBitmap;
+#endif
+extern CPU_INT32U scriptControlWord[MAX_NUMBER_SCRIPTS + 1];
+extern volatile CPU_INT32U scriptActiveBitmap;
+extern volatile CPU_INT32U scriptLoadedBitmap;
 
 /*-------- PROTOTYPES ---------- */
 void Scripts_Init(void);
@@ -62,6 +111,10 @@ CPU_INT08U RunScriptImmediate(UNS8 scriptNumber);
 void Scripts_Enabled( void);
 void Scripts_Disabled( void );
 void RunScriptTask(void);
+#if (RUNSCRIPT_BG_LANE_EN > 0u)
+void RunScriptBackgroundTask(void);
+#endif
+CPU_INT08U ScriptLane_Current(void);
 CPU_INT08U ReadLocalFlashMemory(void);
 CPU_INT08U ReadRemoteFlashMemory(void);
 CPU_INT08U ReadRemoteRAMMemory(void);
@@ -84,7 +137,8 @@ CPU_INT08U RunScriptMultiple(CPU_INT32U decodeValue);
 CPU_INT08U RunScriptMultiple(CPU_INT32U decodeValue);  
 CPU_INT08U GetNodeTable(CPU_INT08U * nodeTable);
 CPU_INT08U ClearLogfile(UNS8 logFileNumber);
-CPU_INT08U AddScriptToQueue(CPU_INT08U ScriptPointer);
+CPU_INT08U AddScriptToQueue(CPU_INT08U ScriptPointer, CPU_INT08U triggerSource);
+void ScriptControl_Init(void);
 void EnableTPDOs(UNS8 mode);
 void ReadMemoryWithIncrement(UNS8 memSelect);
 UNS16 calculateScriptCRC16(UNS8 scriptPointer);
@@ -142,6 +142,7 @@ void initAccelerometer( void )
 void updateAccelerometer( void )
 {
 	UINT8 accelData[6], gyroData[6];
+	UINT8 previous[sizeof(AccelerometersPM)], changed;
 	CPU_SR    cpu_sr;
 	UINT8 err = 1;
 	UINT8 retry = TWI_MAX_TRIES;
@@ -171,6 +172,7 @@ void updateAccelerometer( void )
 	
 	CPU_CRITICAL_ENTER();
 	
+	memcpy( previous, AccelerometersPM, sizeof(previous) );
 	if(err== 0)  
         {
           if(accel_addr == IMU_ADDR)
@@ -205,9 +207,13 @@ void updateAccelerometer( void )
         {
           memset( &AccelerometersPM[0], 0xFF, 4 ); //set error values
         }
+	changed = memcmp( previous, AccelerometersPM, sizeof(previous) ) != 0;
           
 	CPU_CRITICAL_EXIT();
 	
+	if (changed)
+	  MarkTPDOChanged( AccelerometersPM, sizeof(AccelerometersPM) );
+	
 }
 
 void sleepAccelerometer( void )
@@ -205,6 +205,7 @@ void UpdateFuelGauges( UINT8 battNum )
 	//UINT8 eeprom[10]; //JML DEBUG ONLY
 	CPU_SR    cpu_sr;
 	PACK_OD_VAR const *odVar;
+	UINT8 changed;
 		
 		
 	/* read battery pack status */
@@ -242,6 +243,10 @@ void UpdateFuelGauges( UINT8 battNum )
         
         CPU_CRITICAL_ENTER();
         
+        changed = *odVar->tempr != batt1.tempr || *odVar->count != batt2.cycleCnt ||
+                  *odVar->current != batt1.avgCurrent || *odVar->volts != batt1.volt ||
+                  *odVar->nac != batt1.nac || *odVar->rsoc != batt1.rsoc || *odVar->csoc != batt2.csoc ||
+                  *odVar->status != batt1.status || *odVar->lmd != batt1.lmd;
         *odVar->tempr   = batt1.tempr;
         *odVar->count   = batt2.cycleCnt;
         *odVar->current = batt1.avgCurrent;
@@ -253,6 +258,9 @@ void UpdateFuelGauges( UINT8 battNum )
         *odVar->lmd     = batt1.lmd;
         
         CPU_CRITICAL_EXIT();
+        
+        if (changed)
+          MarkTPDOChanged( odVar->tempr, sizeof(Battery1Charge_Status) ); //tempr is the start of BatteryxCharge_Status
 
 }
 
@@ -270,6 +278,8 @@ void MaintainBatteryCharger( void )
 // assumes a call rate of 100msec
 	UINT8  control, enableTimer=0;
 	CHARGER_OD_VAR const *charger;
+	UINT16 nfVoltage, systemVoltage, networkVoltage, moduleLoad;
+	UINT8  isEnabled, command;
 	
         static UINT8 avgCounter = AVG_SAMPLES-1;
         static UINT8 avgStartCounter = 1;
@@ -280,6 +290,14 @@ void MaintainBatteryCharger( void )
                       netVoltageBuffer[AVG_SAMPLES] = {0}, moduleLoadBuffer[AVG_SAMPLES] = {0};
 	
 	charger = &battChargerOdVar;
+        
+        //values on entry, only the changed ones are marked for the TPDOs
+        nfVoltage = *charger->nfVoltage;
+        systemVoltage = *charger->systemVoltage;
+        networkVoltage = *charger->networkVoltage;
+        moduleLoad = *charger->moduleLoad;
+        isEnabled = *charger->isEnabled;
+        command = *charger->command;
 
         //JML changed this: increased to UINT32:
         //apply AVG_SAMPLES sample windowed average on analog values to reduce noise 
@@ -436,6 +454,18 @@ void MaintainBatteryCharger( void )
 	/*apply changes to the PWM*/
 	setChargerPwm( *charger->command );
 	
+        if (*charger->nfVoltage != nfVoltage)
+          MarkTPDOChanged( charger->nfVoltage, sizeof(UINT16) );
+        if (*charger->systemVoltage != systemVoltage)
+          MarkTPDOChanged( charger->systemVoltage, sizeof(UINT16) );
+        if (*charger->networkVoltage != networkVoltage)
+          MarkTPDOChanged( charger->networkVoltage, sizeof(UINT16) );
+        if (*charger->moduleLoad != moduleLoad)
+          MarkTPDOChanged( charger->moduleLoad, sizeof(UINT16) );
+        if (*charger->isEnabled != isEnabled)
+          MarkTPDOChanged( charger->isEnabled, sizeof(UINT8) );
+        if (*charger->command != command)
+          MarkTPDOChanged( charger->command, sizeof(UINT8) );
 }
 
 void DisableCharging( void )
@@ -445,7 +475,11 @@ void DisableCharging( void )
   connBattToCharger( 2, 0 );
   
   setChargerPwm( 0 );
-  BatteryControl_CommandedChargingCurrent = 0;
+  if (BatteryControl_CommandedChargingCurrent != 0)
+  {
+    BatteryControl_CommandedChargingCurrent = 0;
+    MarkTPDOChanged( &BatteryControl_CommandedChargingCurrent, sizeof(BatteryControl_CommandedChargingCurrent) );
+  }
 }
 
 
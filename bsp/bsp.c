@@ -468,7 +468,7 @@ void  BSP_Tmr_TickISR_Handler (void)
       //if not in low power
       if (!(BatteryControl_LowPowerStatus & BIT7)) 
       {
-        AddScriptToQueue(ROUND_ROBIN_SCRIPT);
+        AddScriptToQueue(ROUND_ROBIN_SCRIPT, SCRIPT_TRIGGER_ROUND_ROBIN);
       }
      
     }  
@@ -650,7 +650,7 @@ void RTC_Alarm_ISR(void)
             continue;
           }
           alarm = TRUE;
-          AddScriptToQueue(scriptAlarmTable[i]);
+          AddScriptToQueue(scriptAlarmTable[i], SCRIPT_TRIGGER_ALARM);
         }
       }
     }
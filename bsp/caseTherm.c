@@ -208,12 +208,21 @@ void updateCaseThermometer( UINT8 state )
                   
                   t = calcCaseTempr( d.s );
                   
-                  Status_TemperatureCount = d.s;
-                  Temperature = t;
+                  if (Status_TemperatureCount != d.s)
+                  {
+                    Status_TemperatureCount = d.s;
+                    MarkTPDOChanged( &Status_TemperatureCount, sizeof(Status_TemperatureCount) );
+                  }
                 }
                 else
                 {
-                  Temperature = 0xFFFF; //set error values
+                  t = 0xFFFF; //set error values
+                }
+                
+                if (Temperature != t)
+                {
+                  Temperature = t;
+                  MarkTPDOChanged( &Temperature, sizeof(Temperature) );
                 }
                 
                   
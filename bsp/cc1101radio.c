@@ -180,6 +180,10 @@ static struct
 	enum {RS_IDLE, RS_RECEIVER, RS_TRANSMITTER} state;
 	UINT8 worIsEnabled ;
         UINT8 inSession;
+        UINT8 wakeable;     //radio task is pending for a packet and may be woken by wakeRadioReceiver()
+        UINT8 wakeRequest;  //a response is waiting to be sent, see wakeRadioReceiver()
+        UINT8 wakeTimed;    //wakeTick is armed, see wakeRadioReceiverAfter()
+        OS_TICK wakeTick;
 	UINT8 isrCnt;
 	UINT8 errorCnt;
 	
@@ -335,6 +339,7 @@ const UINT8 ccValueLookUp[47] = { 0x6F,  // 0 -15.50  12.4
 static void configRadioControlPins( void );
 static UINT8 readStatusRegister( UINT8 regNum );
 static void flushFifosSetIdle( void );
+static void pendRadioPacket( OS_TICK timeout, OS_ERR *p_err );
 
 static UINT8 wrConfigurationReg( UINT8 regAddr, UINT8 value );
 static UINT8 readRegisters( UINT8 regAddr, UINT8 *buf, UINT8 numRegisters );
@@ -585,6 +590,136 @@ void sendRadioPacket( UINT8 deviceID, const UINT8 *data, UINT8 dataLen )
 #define MIN_PKT_LEN		4					// len, addr, data, rssi, lqi
 
 
+/**********************************************************************************************************
+*                                             isRadioInSession()
+**********************************************************************************************************/
+/**
+* @brief TRUE while the tower is expected to listen: a packet was received within the session length, 
+*       or sessions are disabled (RADIO_SessionLength == 0) and the receiver is always on.
+* @param none
+* @return TRUE/FALSE
+*/
+CPU_BOOLEAN isRadioInSession( void )
+{
+  return (RADIO_SessionLength == 0 || radio.inSession);
+}
+
+/**********************************************************************************************************
+*                                             wakeRadioReceiver()
+**********************************************************************************************************/
+/**
+* @brief Called by another task when a response is ready for the radio task (see runRadioGateway).  If the
+*       radio task is waiting for a packet in getRadioPacket, the wait is aborted and getRadioPacket returns 0
+*       with the radio idle, so the response can be sent.  Otherwise the request is held until the next
+*       call to getRadioPacket.  A packet that is already being received (sync detected) is completed first.
+* @param none
+* @return none
+*/
+void wakeRadioReceiver( void )
+{
+  OS_ERR err;
+  CPU_BOOLEAN abort;
+  CPU_SR cpu_sr;
+  
+  CPU_CRITICAL_ENTER();
+  radio.wakeRequest = TRUE;
+  abort = radio.wakeable && !RX_IS_READY();
+  if(abort)
+    radio.wakeable = FALSE;
+  CPU_CRITICAL_EXIT();
+  
+  if(abort)
+    OSSemPendAbort(&RadioISR_Sem, OS_OPT_PEND_ABORT_1, &err);
+}
+
+/**********************************************************************************************************
+*                                             wakeRadioReceiverAfter()
+**********************************************************************************************************/
+/**
+* @brief Called by the radio task to be woken as by wakeRadioReceiver() after ticks, e.g. to time out a request
+*       it is waiting on while listening.  Replaces the wake armed before, 0 cancels it.
+* @param ticks
+* @return none
+*/
+void wakeRadioReceiverAfter( OS_TICK ticks )
+{
+  OS_ERR err;
+  
+  radio.wakeTick = OSTimeGet(&err) + ticks;
+  radio.wakeTimed = (ticks != 0);
+}
+
+/* Pends on RadioISR_Sem for a received packet.  *p_err is OS_ERR_PEND_ABORT if woken by wakeRadioReceiver() 
+   or by the wake armed with wakeRadioReceiverAfter() */
+static void pendRadioPacket( OS_TICK timeout, OS_ERR *p_err )
+{
+  CPU_TS ts;
+  OS_TICK ticks, wakeTicks;
+  CPU_BOOLEAN abort;
+  CPU_SR cpu_sr;
+  
+  CPU_CRITICAL_ENTER();
+  if(radio.wakeRequest && !RX_IS_READY())
+  {
+    radio.wakeRequest = FALSE;
+    CPU_CRITICAL_EXIT();
+    *p_err = OS_ERR_PEND_ABORT;
+  }
+  else
+  {
+    radio.wakeable = TRUE;
+    CPU_CRITICAL_EXIT();
+    
+    BatteryControl_LowPowerStatus |= BIT4; //radio is pending
+    while(DEF_TRUE)
+    {
+      ticks = timeout;
+      if(radio.wakeTimed)
+      {
+        wakeTicks = radio.wakeTick - OSTimeGet(p_err);
+        if(wakeTicks == 0 || wakeTicks >= 0x80000000) //due
+          wakeTicks = 1;
+        if(timeout == 0 || wakeTicks < timeout)
+          ticks = wakeTicks;
+      }
+      OSSemPend(&RadioISR_Sem, ticks, OS_OPT_PEND_BLOCKING, &ts, p_err);
+      if(*p_err != OS_ERR_TIMEOUT || ticks == timeout)
+        break;
+      
+      //the armed wake is due, served like wakeRadioReceiver(): a packet being received is completed first
+      radio.wakeTimed = FALSE;
+      CPU_CRITICAL_ENTER();
+      abort = !RX_IS_READY();
+      if(!abort)
+        radio.wakeRequest = TRUE;
+      CPU_CRITICAL_EXIT();
+      if(abort)
+      {
+        *p_err = OS_ERR_PEND_ABORT;
+        break;
+      }
+      if(timeout)
+        timeout -= ticks;
+    }
+    BatteryControl_LowPowerStatus &=~ BIT4; //radio is not pending
+    
+    CPU_CRITICAL_ENTER();
+    radio.wakeable = FALSE;
+    if(*p_err == OS_ERR_PEND_ABORT)
+      radio.wakeRequest = FALSE;
+    CPU_CRITICAL_EXIT();
+  }
+  
+  if(*p_err == OS_ERR_PEND_ABORT)
+  {
+    CPU_CRITICAL_ENTER();
+    flushFifosSetIdle();
+    radio.state = RS_IDLE;
+    CPU_CRITICAL_EXIT();
+  }
+}
+
+
 /**********************************************************************************************************
 *                                             getRadioPacket()
 **********************************************************************************************************/
@@ -610,16 +745,26 @@ UINT8 getRadioPacket( UINT8 *data )
 	
     UINT8 len = 0 ;
     OS_ERR err;
-    CPU_TS ts;
     static OS_TICK sessionStartTick;
     OS_TICK sessionTicks, delayTicks;
     OS_TICK sessionMaxTicks = (RADIO_SessionLength * 1000)/MS_PER_TICK;
     OS_TICK preambleMaxTicks = ((RADIO_WakeInterval + 4)*10 + 5)/MS_PER_TICK;
+    CPU_SR cpu_sr;
     
     while(RADIO_SessionLength > 0)
     { 
       if(!radio.inSession)
       {
+        if(radio.wakeRequest || radio.wakeTimed)
+        {
+          //the channel loop can't be woken: return to the caller to complete its request first
+          CPU_CRITICAL_ENTER();
+          radio.wakeRequest = FALSE;
+          flushFifosSetIdle();
+          radio.state = RS_IDLE;
+          CPU_CRITICAL_EXIT();
+          return 0;
+        }
         enableRadio_ChannelLoop(); 
         sessionStartTick = OSTimeGet(&err); 
       }
@@ -641,14 +786,16 @@ UINT8 getRadioPacket( UINT8 *data )
         {
           delayTicks = preambleMaxTicks;
         }
-        BatteryControl_LowPowerStatus |= BIT4; //radio is pending
-        OSSemPend(&RadioISR_Sem, delayTicks, OS_OPT_PEND_BLOCKING, &ts, &err);
-        BatteryControl_LowPowerStatus &=~ BIT4; //radio is not pending
+        pendRadioPacket(delayTicks, &err);
         if (err == OS_ERR_NONE) 
         {
           //got packet, but radio doesn't count as in session until packet is confirmed
           break; 
         }
+        else if (err == OS_ERR_PEND_ABORT)
+        {
+          return 0; //woken to send a response, radio is idle
+        }
         else //timed out (either done with session or wasn't in session yet and didn't get packet after finding preamble), go back to channel loop
         {
           radio.inSession = FALSE;
@@ -658,9 +805,11 @@ UINT8 getRadioPacket( UINT8 *data )
     
     if(RADIO_SessionLength == 0)
     {
-      BatteryControl_LowPowerStatus |= BIT4; //radio is pending
-      OSSemPend(&RadioISR_Sem, 0, OS_OPT_PEND_BLOCKING, &ts, &err);
-      BatteryControl_LowPowerStatus &=~ BIT4; //radio is not pending
+      pendRadioPacket(0, &err);
+      if (err == OS_ERR_PEND_ABORT)
+      {
+        return 0; //woken to send a response, radio is idle
+      }
     }
     
 
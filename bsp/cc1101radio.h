@@ -32,6 +32,9 @@ void initRadioConfig( void );
 void sendRadioPacket( CPU_INT08U deviceID, const CPU_INT08U *data, CPU_INT08U dataLen );
 CPU_INT08U getRadioPacket( CPU_INT08U *data );
 void enableRadioReceiver( void );
+void wakeRadioReceiver( void );
+void wakeRadioReceiverAfter( OS_TICK ticks );
+CPU_BOOLEAN isRadioInSession( void );
 void enableRadio_WOR();
 void disableRadio_WOR();
 void powerDownRadio();
@@ -41,6 +41,7 @@ void InitPowerNetwork( void )
   {
     
     NetworkPowerControl |= 0x01; // turn on Bit 0
+    MarkTPDOChanged( &NetworkPowerControl, sizeof(NetworkPowerControl) );
     
     if( updatePowerNetwork() ) // wait until network comes on
     {
@@ -126,6 +127,7 @@ UINT8 updatePowerNetwork( void )
           if (NetworkVoltage < 47 || NetworkVoltage > 96) // restore failed (or voltage out of range), set to default
           {
             NetworkVoltage = VNET_DEFAULT;  
+            MarkTPDOChanged( &NetworkVoltage, sizeof(NetworkVoltage) );
           }
           vNet = NetworkVoltage;
              
@@ -127,6 +127,12 @@ UNS8 TransferBuffer_Copy[48] =
 UNS8 TransferBuffer_Flag = 0x00;
 UNS8 TransferBuffer_Counter = 0x00;
 UNS8 TransferBuffer_RadioCounter = 0x00;
+UNS8 TransferBuffer_StreamMode = 0x00;       //1: HS data is pushed over the radio (see QueueHSStream), 0: polled at 0x2053.3
+UNS16 TransferBuffer_StreamSent = 0x00;      //HS stream packets sent
+UNS16 TransferBuffer_StreamDrops = 0x00;     //HS buffers dropped because the stream ring was full, write 0 to reset
+UNS8 TransferBuffer_StreamCodec = 0x00;      //1: stream packets are delta/zig-zag varint coded when smaller (see PKT_PC_HS_STREAM_DELTA), 0: raw only
+UNS32 TransferBuffer_StreamBytes = 0x00;     //HS stream payload bytes sent (raw: 48 per buffer), write 0 to reset
+UNS16 TransferBuffer_StreamEncodeCycles = 0x00; //longest delta encode, CPU cycles, write 0 to reset
 UNS32 addressCounter = 100;
 UNS8 App8[250] =  /*1F53*/
 { 0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,\
@@ -150,6 +156,11 @@ UNS8 AppSave8[150] = /*1F57*/
   0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,\
   0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0,  0,0,0,0,0};
 UNS16 Script_Management[25] =  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }; /*1F58*/
+UNS8 ScriptStats_Trigger[25][8]; /*1F59 - see SCRIPT_STAT_xxx in scripts.h*/
+UNS16 ScriptStats_ScanTime[25][3]; /*1F5A - see SCRIPT_SCAN_xxx in scripts.h*/
+UNS16 ScriptStats_ScanBudget = 0; /*1F5A.1A - Timer1 counts (8us), 0 = no overrun check*/
+UNS8 ScriptStats_ScanControl = 0; /*1F5A.1B - BIT0 EMCY on overrun, BIT7 reset statistics*/
+UNS16 ScriptStats_ScanHistogram[8]; /*1F5A.1C - all scripts, see SCRIPT_SCAN_BUCKETS in scripts.h*/
 
 UNS16 CAN_FormErrors = 0x00;
 UNS16 CAN_StuffErrors = 0x00;
@@ -160,13 +171,26 @@ UNS16 CAN_Rx_ErrCounter = 0x00;
 UNS16 CAN_Tx_ErrCounter = 0x00;
 UNS16 CAN_Receive_BEI = 0x00;
 UNS16 CAN_Receive_Messages = 0x00;
+UNS16 CAN_Receive_Overruns = 0;    //frames lost because the receive ring was full, write 0 to reset
+UNS8 CAN_Receive_MaxBatch = 0;     //most frames dispatched in one RunCANServerTask wakeup, write 0 to reset
 UNS16 CAN_Transmit_Messages = 0x00;
-UNS16 CAN_EnabledInterrupts = 0x00; /*should read 0x87 */
+UNS8 CAN_Transmit_QueueMax = 0;       //most frames in the TX priority queue, write 0 to reset
+UNS8 CAN_Transmit_BuffersMax = 0;     //most TX buffers loaded at once (of 3), write 0 to reset
+UNS16 CAN_Transmit_Waits = 0;         //ticks canSend waited for space in a full TX queue, write 0 to reset
+UNS16 CAN_Transmit_MaxLatency[4] = {0, 0, 0, 0};  //us from canSend to sent, worst case for NMT/SYNC/EMCY, PDO, SDO, heartbeat, write 0 to reset
+UNS16 CAN_EnabledInterrupts = 0x00; /*should read 0x687 */
 UNS16 CAN_RX_ResetCounter = 0x00;
 UNS16 CAN_TX_ResetCounter = 0x00;
 UNS16 CAN_NS_ResetCounter = 0x00;
 UNS8 CAN_ClearOnSYNC = 0x00;   //cleared on SYNC, can be used by script to count occurrences between syncs
 UNS32 CAN_UpTime = 0;
+UNS16 CAN_Gateway_CacheHits = 0;           //remote reads served from the gateway cache, write 0 to reset
+UNS16 CAN_Gateway_CacheMisses = 0;         //cacheable remote reads sent as SDO, write 0 to reset
+UNS16 CAN_Gateway_CacheInvalidations = 0;  //cached entries dropped by writes, node boot/reset, write 0 to reset
+UNS16 CAN_Gateway_FastFallbacks = 0;      //fast path reads answered with a segmented upload and redone, write 0 to reset
+UNS16 CAN_Gateway_FastLatency = 0;        //us from request to reply, last expedited fast path request
+UNS16 CAN_Gateway_SlowLatency = 0;        //us from request to reply, last request through the CanFestival SDO lines
+UNS8 CAN_Gateway_BlockTransfer = 0;       //1: segmented remote reads/writes use SDO block transfer (remote node must support it)
 UNS8 RADIO_LocalAddress = 0x04;
 UNS8 RADIO_RemoteAddress = 0x03;
 UNS8 RADIO_ChannelNumber = 0x05;
@@ -181,6 +205,13 @@ UNS16 RADIO_RX_Rec_Partial = 0x00;
 UNS16 RADIO_SDO_Script_Failures = 0;
 UNS16 RADIO_WakeInterval = 20; //in ms, 14-1890
 UNS8 RADIO_SessionLength = 0;  //time in s before channel listen loop reenabled (0 disables), For MedRadio, should set to 5
+UNS16 RADIO_Remote_Requests = 0;    //radio requests routed to a CAN node
+UNS16 RADIO_Remote_Overlapped = 0;  //radio requests served while a CAN request was in flight
+UNS16 RADIO_Remote_Latency = 0;     //ms from radio request to CAN response, last request
+UNS16 RADIO_Remote_LatencyMax = 0;  //ms, write 0 to reset
+UNS8 RADIO_Window_Size = 8;         //fragments per windowed file upload request, at most FILE_WINDOW_MAX
+UNS16 RADIO_Window_Fragments = 0;   //windowed upload fragments sent
+UNS16 RADIO_Window_Resent = 0;      //windowed upload fragments sent again because the tower missed them
 UNS8 BatteryControl_PowerControl = 0xFF;		/* Mapped at index 0x3000, subindex 0x01 - battery charge control*/
 UNS8 BatteryControl_BatteryChargingStepIncrement = 0x1;		/* Mapped at index 0x3000, subindex 0x02 */
 UNS16 BatteryControl_BatteryChargingInterval = 0x05; /*~ 0.5s*/	/* Mapped at index 0x3000, subindex 0x03 */
@@ -240,6 +271,7 @@ UNS8 StackScript = 0;
 UNS8 StackTick = 0;
 UNS8 StackIdle = 0;
 UNS8 StackStats = 0;
+UNS8 StackScriptBackground = 0; //0 unless RUNSCRIPT_BG_LANE_EN
 
 //Restore List mapped at 0x2900
 //The current restore space is limited to 1024 Bytes
@@ -1233,6 +1265,35 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                     
 /* index 0x1F51 :   Mapped variable Scripts */
                     const UNS8 ObjDict_highestSubIndex_obj1F51 = 25; /* number of subindex - 1*/
+                    ODCallback_t ObjDict_Index1F51_callbacks[] = 
+                     {
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                     };
                     const subindex ObjDict_Index1F51[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1F51 },
@@ -1758,6 +1819,105 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                      };
                     
                     
+/* index 0x1F59 :   Mapped variable Script Trigger Statistics (write zeros to reset) */
+                    const UNS8 ObjDict_highestSubIndex_obj1F59 = 25; /* number of subindex - 1*/
+                    const subindex ObjDict_Index1F59[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1F59 },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[0][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[1][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[2][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[3][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[4][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[5][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[6][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[7][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[8][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[9][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[10][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[11][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[12][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[13][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[14][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[15][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[16][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[17][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[18][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[19][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[20][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[21][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[22][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[23][0] },
+                       { RW, uint8, sizeof(ScriptStats_Trigger[0]), (void*)&ScriptStats_Trigger[24][0] }
+                     };
+                    
+/* index 0x1F5A :   Mapped variable Script Scan Time Statistics (1..25 write zeros to reset, 26 budget, 27 control, 28 histogram) */
+                    const UNS8 ObjDict_highestSubIndex_obj1F5A = 28; /* number of subindex - 1*/
+                    ODCallback_t ObjDict_Index1F5A_callbacks[] = 
+                     {
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL
+                     };
+                    const subindex ObjDict_Index1F5A[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1F5A },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[0][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[1][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[2][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[3][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[4][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[5][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[6][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[7][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[8][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[9][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[10][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[11][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[12][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[13][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[14][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[15][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[16][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[17][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[18][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[19][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[20][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[21][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[22][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[23][0] },
+                       { RW, uint16, sizeof(ScriptStats_ScanTime[0]), (void*)&ScriptStats_ScanTime[24][0] },
+                       { RW, uint16, sizeof (UNS16), (void*)&ScriptStats_ScanBudget },
+                       { RW, uint8, sizeof (UNS8), (void*)&ScriptStats_ScanControl },
+                       { RW, uint16, sizeof(ScriptStats_ScanHistogram), (void*)&ScriptStats_ScanHistogram[0] }
+                     };
+                    
 /* index 0x2001 :   Mapped variable Control */
                     const UNS8 ObjDict_highestSubIndex_obj2001 = 5; /* number of subindex - 1*/
                     const subindex ObjDict_Index2001[] = 
@@ -1845,7 +2005,7 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
 
 
 /* index 0x2053 :   Mapped variable HS Transfer */
-                    const UNS8 ObjDict_highestSubIndex_obj2053 = 5; /* number of subindex - 1*/
+                    const UNS8 ObjDict_highestSubIndex_obj2053 = 11; /* number of subindex - 1*/
                     const subindex ObjDict_Index2053[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2053 },
@@ -1853,12 +2013,18 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RW, uint8, sizeof(TransferBuffer_Copy), (void*)&TransferBuffer_Copy[0] },
                        { RO, uint8, sizeof (UNS8), (void*)&TransferBuffer_Flag },
                        { RO, uint8, sizeof (UNS8), (void*)&TransferBuffer_Counter },
-                       { RO, uint8, sizeof (UNS8), (void*)&TransferBuffer_RadioCounter }
+                       { RO, uint8, sizeof (UNS8), (void*)&TransferBuffer_RadioCounter },
+                       { RW, uint8, sizeof (UNS8), (void*)&TransferBuffer_StreamMode },
+                       { RO, uint16, sizeof (UNS16), (void*)&TransferBuffer_StreamSent },
+                       { RW, uint16, sizeof (UNS16), (void*)&TransferBuffer_StreamDrops },
+                       { RW, uint8, sizeof (UNS8), (void*)&TransferBuffer_StreamCodec },
+                       { RW, uint32, sizeof (UNS32), (void*)&TransferBuffer_StreamBytes },
+                       { RW, uint16, sizeof (UNS16), (void*)&TransferBuffer_StreamEncodeCycles }
                      };                    
                     
 
 /* index 0x2500 :   Mapped variable CAN */
-                    const UNS8 ObjDict_highestSubIndex_obj2500 = 16; /* number of subindex - 1*/
+                    const UNS8 ObjDict_highestSubIndex_obj2500 = 32; /* number of subindex - 1*/
                     const subindex ObjDict_Index2500[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2500 },
@@ -1877,12 +2043,28 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RO, uint16, sizeof (UNS16),  (void*)&CAN_TX_ResetCounter },
                        { RO, uint16, sizeof (UNS16),  (void*)&CAN_NS_ResetCounter },
                        { RW, uint16, sizeof (UNS8),  (void*)&CAN_ClearOnSYNC },
-                       { RO, uint32, sizeof (UNS32),  (void*)&CAN_UpTime }
+                       { RO, uint32, sizeof (UNS32),  (void*)&CAN_UpTime },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Gateway_CacheHits },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Gateway_CacheMisses },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Gateway_CacheInvalidations },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Gateway_FastFallbacks },
+                       { RO, uint16, sizeof (UNS16),  (void*)&CAN_Gateway_FastLatency },
+                       { RO, uint16, sizeof (UNS16),  (void*)&CAN_Gateway_SlowLatency },
+                       { RW, uint8, sizeof (UNS8),  (void*)&CAN_Gateway_BlockTransfer },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Receive_Overruns },
+                       { RW, uint8, sizeof (UNS8),  (void*)&CAN_Receive_MaxBatch },
+                       { RW, uint8, sizeof (UNS8),  (void*)&CAN_Transmit_QueueMax },
+                       { RW, uint8, sizeof (UNS8),  (void*)&CAN_Transmit_BuffersMax },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Transmit_Waits },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Transmit_MaxLatency[0] },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Transmit_MaxLatency[1] },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Transmit_MaxLatency[2] },
+                       { RW, uint16, sizeof (UNS16),  (void*)&CAN_Transmit_MaxLatency[3] }
 
                      };
                     
 /* index 0x2600 :   Mapped variable RADIO */
-                    const UNS8 ObjDict_highestSubIndex_obj2600 = 14; /* number of subindex - 1*/
+                    const UNS8 ObjDict_highestSubIndex_obj2600 = 21; /* number of subindex - 1*/
                     const subindex ObjDict_Index2600[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2600 },
@@ -1899,7 +2081,14 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RO, uint16, sizeof (UNS16), (void*)&RADIO_RX_Rec },
                        { RO, uint16, sizeof (UNS16), (void*)&RADIO_RX_Rec_Partial},
                        { RW, uint16, sizeof (UNS16), (void*)&RADIO_SDO_Script_Failures },
-                       { RW, uint8, sizeof (UNS8), (void*)&RADIO_SessionLength }
+                       { RW, uint8, sizeof (UNS8), (void*)&RADIO_SessionLength },
+                       { RO, uint16, sizeof (UNS16), (void*)&RADIO_Remote_Requests },
+                       { RO, uint16, sizeof (UNS16), (void*)&RADIO_Remote_Overlapped },
+                       { RO, uint16, sizeof (UNS16), (void*)&RADIO_Remote_Latency },
+                       { RW, uint16, sizeof (UNS16), (void*)&RADIO_Remote_LatencyMax },
+                       { RW, uint8, sizeof (UNS8), (void*)&RADIO_Window_Size },
+                       { RW, uint16, sizeof (UNS16), (void*)&RADIO_Window_Fragments },
+                       { RW, uint16, sizeof (UNS16), (void*)&RADIO_Window_Resent }
                        
                      
                      };
@@ -2064,7 +2253,7 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                       };
 
 /* index 0x3030 :   Mapped variable StackMonitor */
-                    const UNS8 ObjDict_highestSubIndex_obj3030 = 9; /* number of subindex - 1*/
+                    const UNS8 ObjDict_highestSubIndex_obj3030 = 10; /* number of subindex - 1*/
                     const subindex ObjDict_Index3030[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj3030 },
@@ -2076,7 +2265,8 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RO, uint8, sizeof (UNS8), (void*)&StackScript },
                        { RO, uint8, sizeof (UNS8), (void*)&StackTick },
                        { RO, uint8, sizeof (UNS8), (void*)&StackIdle },
-                       { RO, uint8, sizeof (UNS8), (void*)&StackStats }
+                       { RO, uint8, sizeof (UNS8), (void*)&StackStats },
+                       { RO, uint8, sizeof (UNS8), (void*)&StackScriptBackground }
                      };
 
 /* index 0xA200 :   Mapped variable WriteFiles */
@@ -2095,6 +2285,7 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
 /* Declaration of variables                                       */
 /**************************************************************************/
 
+/* Must stay sorted by index, see ObjDict_scanIndexOD */
 const indextable ObjDict_objdict[] = 
 {
   { (subindex*)ObjDict_Index1000,sizeof(ObjDict_Index1000)/sizeof(ObjDict_Index1000[0]), 0x1000},
@@ -2157,6 +2348,8 @@ const indextable ObjDict_objdict[] =
   { (subindex*)ObjDict_Index1F56,sizeof(ObjDict_Index1F56)/sizeof(ObjDict_Index1F56[0]), 0x1F56},
   { (subindex*)ObjDict_Index1F57,sizeof(ObjDict_Index1F57)/sizeof(ObjDict_Index1F57[0]), 0x1F57},
   { (subindex*)ObjDict_Index1F58,sizeof(ObjDict_Index1F58)/sizeof(ObjDict_Index1F58[0]), 0x1F58},
+  { (subindex*)ObjDict_Index1F59,sizeof(ObjDict_Index1F59)/sizeof(ObjDict_Index1F59[0]), 0x1F59},
+  { (subindex*)ObjDict_Index1F5A,sizeof(ObjDict_Index1F5A)/sizeof(ObjDict_Index1F5A[0]), 0x1F5A},
   { (subindex*)ObjDict_Index2001,sizeof(ObjDict_Index2001)/sizeof(ObjDict_Index2001[0]), 0x2001},
   { (subindex*)ObjDict_Index2003,sizeof(ObjDict_Index2003)/sizeof(ObjDict_Index2003[0]), 0x2003},
   { (subindex*)ObjDict_Index2004,sizeof(ObjDict_Index2004)/sizeof(ObjDict_Index2004[0]), 0x2004},
@@ -2180,96 +2373,67 @@ const indextable ObjDict_objdict[] =
   
 };
 
+/* Indexes with callbacks returned by ObjDict_scanIndexOD, sorted by index */
+static const struct
+{
+  UNS16 index;
+  ODCallback_t *callbacks;
+} ObjDict_callbacks[] = 
+{
+  { 0x1400, ObjDict_Index1400_callbacks },
+  { 0x1401, ObjDict_Index1401_callbacks },
+  { 0x1402, ObjDict_Index1402_callbacks },
+  { 0x1403, ObjDict_Index1403_callbacks },
+  { 0x1404, ObjDict_Index1404_callbacks },
+  { 0x1405, ObjDict_Index1405_callbacks },
+  { 0x1406, ObjDict_Index1406_callbacks },
+  { 0x1407, ObjDict_Index1407_callbacks },
+  { 0x1800, ObjDict_Index1800_callbacks },
+  { 0x1801, ObjDict_Index1801_callbacks },
+  { 0x1802, ObjDict_Index1802_callbacks },
+  { 0x1803, ObjDict_Index1803_callbacks },
+  { 0x1804, ObjDict_Index1804_callbacks },
+  { 0x1805, ObjDict_Index1805_callbacks },
+  { 0x1F51, ObjDict_Index1F51_callbacks },
+  { 0x1F5A, ObjDict_Index1F5A_callbacks }
+};
+
+/* Binary search of ObjDict_objdict (sorted by index). Adding an object only needs its ObjDict_objdict entry,
+ * and an ObjDict_callbacks entry if it has callbacks. */
 const indextable * ObjDict_scanIndexOD (UNS16 wIndex, UNS32 * errorCode, ODCallback_t **callbacks)
 {
-	int i;
+	int low, high, i;
 	*callbacks = NULL;
-	switch(wIndex)
-        {
-		case 0x1000: i = 0;break;
-                case 0x1001: i = 1;break;
-                case 0x1003: i = 2;break;
-		case 0x1005: i = 3;break;
-		case 0x1006: i = 4;break;
-		case 0x1008: i = 5;break;
-		case 0x1018: i = 6;break;
-		case 0x1200: i = 7;break;
-		case 0x1280: i = 8;break;
-		case 0x1281: i = 9;break;
-		case 0x1282: i = 10;break;
-		case 0x1283: i = 11;break;
-		case 0x1284: i = 12;break;
-                case 0x1285: i = 13;break;
-                case 0x1286: i = 14;break;
-                case 0x1287: i = 15;break;
-                case 0x1288: i = 16;break;
-                case 0x1289: i = 17;break;
-                case 0x128A: i = 18;break;
-                case 0x128B: i = 19;break;
-		case 0x1400: i = 20;*callbacks = ObjDict_Index1400_callbacks;break;
-		case 0x1401: i = 21;*callbacks = ObjDict_Index1401_callbacks;break;
-                case 0x1402: i = 22;*callbacks = ObjDict_Index1402_callbacks;break;
-                case 0x1403: i = 23;*callbacks = ObjDict_Index1403_callbacks;break;   
-                case 0x1404: i = 24;*callbacks = ObjDict_Index1404_callbacks;break;
-		case 0x1405: i = 25;*callbacks = ObjDict_Index1405_callbacks;break;
-                case 0x1406: i = 26;*callbacks = ObjDict_Index1406_callbacks;break;
-                case 0x1407: i = 27;*callbacks = ObjDict_Index1407_callbacks;break;  
-		case 0x1600: i = 28;break;
-		case 0x1601: i = 29;break;
-                case 0x1602: i = 30;break;
-                case 0x1603: i = 31;break;
-                case 0x1604: i = 32;break;
-		case 0x1605: i = 33;break;
-                case 0x1606: i = 34;break;
-                case 0x1607: i = 35;break;
-		case 0x1800: i = 36;*callbacks = ObjDict_Index1800_callbacks; break;
-                case 0x1801: i = 37;*callbacks = ObjDict_Index1801_callbacks; break;
-                case 0x1802: i = 38;*callbacks = ObjDict_Index1802_callbacks; break;
-                case 0x1803: i = 39;*callbacks = ObjDict_Index1803_callbacks; break;
-                case 0x1804: i = 40;*callbacks = ObjDict_Index1804_callbacks; break;
-                case 0x1805: i = 41;*callbacks = ObjDict_Index1805_callbacks; break;
-                //case 0x1806: i = 42;*callbacks = ObjDict_Index1806_callbacks; break;
-                //case 0x1807: i = 43;*callbacks = ObjDict_Index1807_callbacks; break;
-		case 0x1A00: i = 42;break;
-                case 0x1A01: i = 43;break;
-                case 0x1A02: i = 44;break;
-                case 0x1A03: i = 45;break;
-                case 0x1A04: i = 46;break;
-                case 0x1A05: i = 47;break;
-                //case 0x1A06: i = 50;break;
-                //case 0x1A07: i = 51;break;
-                case 0x1F51: i = 48;break;
-                case 0x1F52: i = 49;break;
-                case 0x1F53: i = 50;break;
-                case 0x1F54: i = 51;break;
-                case 0x1F55: i = 52;break;
-                case 0x1F56: i = 53;break;
-                case 0x1F57: i = 54;break;
-                case 0x1F58: i = 55;break;
-		case 0x2001: i = 56;break;		
-		case 0x2003: i = 57;break;
-		case 0x2004: i = 58;break;
-		case 0x2010: i = 59;break;
-		case 0x2011: i = 60;break;
-		case 0x2020: i = 61;break;
-                case 0x2053: i = 62;break;
-                case 0x2500: i = 63;break;
-                case 0x2600: i = 64;break;
-                case 0x2900: i = 65;break;
-		case 0x3000: i = 66;break;
-                case 0x3001: i = 67;break;
-                case 0x3002: i = 68;break;
-                case 0x3003: i = 69;break;
-                case 0x3004: i = 70;break;
-		case 0x3010: i = 71;break;
-                case 0x3020: i = 72;break;
-                case 0x3021: i = 73;break;
-                case 0x3030: i = 74;break;
-		case 0xA200: i = 75;break; 
-		
-		default:
-			*errorCode = OD_NO_SUCH_OBJECT;
-			return NULL;
+	
+	low = 0;
+	high = sizeof(ObjDict_objdict)/sizeof(ObjDict_objdict[0]) - 1;
+	while (low <= high)
+	{
+		i = (low + high) >> 1;
+		if (ObjDict_objdict[i].index < wIndex)
+			low = i + 1;
+		else if (ObjDict_objdict[i].index > wIndex)
+			high = i - 1;
+		else
+			break;
+	}
+	if (low > high)
+	{
+		*errorCode = OD_NO_SUCH_OBJECT;
+		return NULL;
+	}
+	
+	if (wIndex >= ObjDict_callbacks[0].index && wIndex <= ObjDict_callbacks[sizeof(ObjDict_callbacks)/sizeof(ObjDict_callbacks[0]) - 1].index)
+	{
+		int c;
+		for (c = 0; c < sizeof(ObjDict_callbacks)/sizeof(ObjDict_callbacks[0]); c++)
+		{
+			if (ObjDict_callbacks[c].index == wIndex)
+			{
+				*callbacks = ObjDict_callbacks[c].callbacks;
+				break;
+			}
+		}
 	}
 	*errorCode = OD_SUCCESSFUL;
 	return &ObjDict_objdict[i];
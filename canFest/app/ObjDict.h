@@ -107,11 +107,22 @@ extern UNS8 statusByteMemory;
 extern UNS8 ReadMemoryData[36];
 extern UNS8 Script_Order[25];
 extern UNS16 Script_Management[25];
+extern UNS8 ScriptStats_Trigger[25][8];
+extern UNS16 ScriptStats_ScanTime[25][3];
+extern UNS16 ScriptStats_ScanHistogram[8];
+extern UNS16 ScriptStats_ScanBudget;
+extern UNS8 ScriptStats_ScanControl;
 extern UNS8 TransferBuffer_Working[48];
 extern UNS8 TransferBuffer_Copy[48];
 extern UNS8 TransferBuffer_Flag;
 extern UNS8 TransferBuffer_Counter;
 extern UNS8 TransferBuffer_RadioCounter;
+extern UNS8 TransferBuffer_StreamMode;
+extern UNS16 TransferBuffer_StreamSent;
+extern UNS16 TransferBuffer_StreamDrops;
+extern UNS8 TransferBuffer_StreamCodec;
+extern UNS32 TransferBuffer_StreamBytes;
+extern UNS16 TransferBuffer_StreamEncodeCycles;
 extern UNS32 addressCounter;
 extern const UNS16 RestoreList[36];
 extern UNS8 BatteryControl_PowerControl;		/* Mapped at index 0x3000, subindex 0x01 */
@@ -143,13 +154,26 @@ extern UNS16 CAN_Receive_BEI;
 extern UNS16 CAN_Rx_ErrCounter;
 extern UNS16 CAN_Tx_ErrCounter;
 extern UNS16 CAN_Receive_Messages;
+extern UNS16 CAN_Receive_Overruns;
+extern UNS8 CAN_Receive_MaxBatch;
 extern UNS16 CAN_Transmit_Messages;
+extern UNS8 CAN_Transmit_QueueMax;
+extern UNS8 CAN_Transmit_BuffersMax;
+extern UNS16 CAN_Transmit_Waits;
+extern UNS16 CAN_Transmit_MaxLatency[4];
 extern UNS16 CAN_EnabledInterrupts; 
 extern UNS16 CAN_RX_ResetCounter;
 extern UNS16 CAN_TX_ResetCounter;
 extern UNS16 CAN_NS_ResetCounter;
 extern UNS8 CAN_ClearOnSYNC;
 extern UNS32 CAN_UpTime;
+extern UNS16 CAN_Gateway_CacheHits;
+extern UNS16 CAN_Gateway_CacheMisses;
+extern UNS16 CAN_Gateway_CacheInvalidations;
+extern UNS16 CAN_Gateway_FastFallbacks;
+extern UNS16 CAN_Gateway_FastLatency;
+extern UNS16 CAN_Gateway_SlowLatency;
+extern UNS8 CAN_Gateway_BlockTransfer;
 extern UNS8 RADIO_LocalAddress;
 extern UNS8 RADIO_RemoteAddress;
 extern UNS8 RADIO_ChannelNumber;
@@ -164,6 +188,13 @@ extern UNS16 RADIO_RX_Rec_Partial;
 extern UNS16 RADIO_SDO_Script_Failures;
 extern UNS16 RADIO_WakeInterval;
 extern UNS8 RADIO_SessionLength;
+extern UNS16 RADIO_Remote_Requests;
+extern UNS16 RADIO_Remote_Overlapped;
+extern UNS16 RADIO_Remote_Latency;
+extern UNS16 RADIO_Remote_LatencyMax;
+extern UNS8 RADIO_Window_Size;
+extern UNS16 RADIO_Window_Fragments;
+extern UNS16 RADIO_Window_Resent;
 extern UNS8 ControlOutput1;
 extern UNS8 ControlOutput2;
 extern UNS8 ControlOutput3;
@@ -188,5 +219,6 @@ extern UNS8 StackScript;
 extern UNS8 StackTick;
 extern UNS8 StackIdle;
 extern UNS8 StackStats;
+extern UNS8 StackScriptBackground;
 
 #endif // OBJDICT_H
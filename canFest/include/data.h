@@ -142,7 +142,15 @@ struct struct_CO_Data {
 		{0},        /* data (static use, so that all the table is initialize at 0)*/\
 		0,          /* dataType */\
 		-1,         /* timer */\
-		NULL        /* Callback */\
+		NULL,       /* Callback */\
+		0,          /* blockPhase */\
+		0,          /* blockSize */\
+		0,          /* blockSeq */\
+		0,          /* blockLast */\
+		0,          /* blockCrc */\
+		0,          /* blockStart */\
+		NULL,       /* pObject */\
+		0           /* objectSize */\
 	  },
 
 #define ERROR_DATA_INITIALIZER \
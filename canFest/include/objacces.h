@@ -266,6 +266,31 @@ UNS32 _setODentry( CO_Data* d,
 #define writeLocalDict( d, wIndex, bSubindex, pSourceData, pExpectedSize, checkAccess) \
        _setODentry( d, wIndex, bSubindex, pSourceData, pExpectedSize, checkAccess, 0)
 
+/**
+ * @ingroup od
+ * @brief Reads consecutive subindexes of one index with a single index lookup, packed in machine native 
+ * endianness. All types are packed at their OD size; a visible_string ends after its null terminator.
+ * @param *pSize in: size of pDestData, out: bytes packed
+ * @param *pFailedSub subindex that caused a non OD_SUCCESSFUL return
+ * @return 
+ * - OD_SUCCESSFUL is returned upon success. 
+ * - SDO abort code is returned if error occurs . (See file def.h)
+ */
+UNS32 readLocalDictBlock( CO_Data* d, UNS16 wIndex, UNS8 bSubindex, UNS8 nSub, 
+                          UNS8 * pDestData, UNS32 * pSize, UNS8 checkAccess, UNS8 * pFailedSub);
+
+/**
+ * @ingroup od
+ * @brief Writes consecutive subindexes of one index with a single index lookup, see writeLocalDict.
+ * @param elemSize size of every packed value, 0: each value has its OD size
+ * @param *pFailedSub subindex that caused a non OD_SUCCESSFUL return, earlier subindexes stay written
+ * @return 
+ * - OD_SUCCESSFUL is returned upon success. 
+ * - SDO abort code is returned if error occurs . (See file def.h)
+ */
+UNS32 writeLocalDictBlock( CO_Data* d, UNS16 wIndex, UNS8 bSubindex, UNS8 nSub, UNS8 elemSize,
+                           UNS8 * pSourceData, UNS32 sourceSize, UNS8 checkAccess, UNS8 * pFailedSub);
+
 
 
 /**
@@ -53,6 +53,12 @@ struct struct_s_PDO_status {
 
 #define s_PDO_status_Initializer {0, TIMER_NONE, TIMER_NONE, Message_Initializer}
 
+/** An OD variable whose writer calls MarkTPDOChanged() */
+typedef struct {
+  const void *pObject;
+  UNS8 size;
+} s_TPDO_marked_object;
+
 /** definitions of the different types of PDOs' transmission
  * 
  * SYNCHRO(n) means that the PDO will be transmited every n SYNC signal.
@@ -130,6 +136,29 @@ UNS8 _sendPDOevent(CO_Data* d, UNS8 isSyncEvent);
  */
 void PDOInit(CO_Data* d);
 
+/** 
+ * @brief Rebuild the compiled PDO mappings and the received PDO lookup before the next PDO is processed
+ */
+void InvalidatePDOTables(void);
+
+/** 
+ * @brief Mark the TPDOs mapping any part of an OD variable, so their next event rebuilds and compares them.
+ * Called by _setODentry; code writing a mapped variable directly must call it too.
+ * @param pObject OD variable that was written
+ * @param size Size of the write in bytes
+ */
+void MarkTPDOChanged(const void * pObject, UNS32 size);
+
+/** 
+ * @brief Register the OD variables that are written directly and marked with MarkTPDOChanged() by every writer
+ * that changes their value.
+ * A TPDO is only rebuilt on demand when all its mapped objects are in this list, other TPDOs are rebuilt and
+ * compared on every event.
+ * @param objects Array of marked variables, must stay valid
+ * @param count Number of entries
+ */
+void SetTPDOMarkedObjects(const s_TPDO_marked_object * objects, UNS8 count);
+
 /** 
  * @brief Stop PDO feature 
  * @param *d Pointer on a CAN object data structure
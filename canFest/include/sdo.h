@@ -41,6 +41,12 @@ struct struct_s_transfer;
 
 typedef void (*SDOCallback_t)(CO_Data* d, UNS8 nodeId);
 
+/* Block transfer phases (s_transfer.blockPhase) */
+#define SDO_BLOCK_INIT  0   /* initiate sent, waiting for the response (or for the start of an upload) */
+#define SDO_BLOCK_DATA  1   /* sub-block in transfer */
+#define SDO_BLOCK_LAST  2   /* sender: the sub-block holding the last segment was sent */
+#define SDO_BLOCK_END   3   /* waiting for the end request or response */
+
 /* The Transfer structure
 Used to store the different segments of
  - a SDO received before writing in the dictionary
@@ -78,7 +84,19 @@ struct struct_s_transfer
                               * when the response SDO have been received.
                               */
   SDOCallback_t Callback;   /**< The user callback func to be called at SDO transaction end */
-  
+  UNS8           blockPhase; /**< Block transfer: SDO_BLOCK_INIT, SDO_BLOCK_DATA, SDO_BLOCK_LAST or SDO_BLOCK_END */
+  UNS8           blockSize;  /**< Segments in the current sub-block */
+  UNS8           blockSeq;   /**< Last segment sent, or received in sequence, in the current sub-block */
+  UNS8           blockLast;  /**< Bytes in the last segment */
+  UNS8           blockCrc;   /**< Both sides support the CRC */
+  UNS32          blockStart; /**< Offset of the first byte of the current sub-block */
+  UNS8          *pObject;    /**< Server only: buffer used instead of data[].
+                              * Uploads read the OD object in place (no copy, the value is not
+                              * frozen during a segmented transfer); downloads of objects larger
+                              * than data[] are collected in the staging area (SDO_STAGING_SIZE).
+                              * A download is written to the dictionary when it is complete.
+                              */
+  UNS32          objectSize; /**< Size of *pObject */
 };
 typedef struct struct_s_transfer s_transfer;
 
@@ -411,6 +429,48 @@ UNS8 readNetworkDictCallback (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subInde
  */
 UNS8 readNetworkDictCallbackAI (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subIndex, UNS8 dataType, SDOCallback_t Callback);
 
+/** 
+ * @ingroup sdo
+ * @brief Used to write in a distant node dictionnary with a CiA 301 SDO block download.
+ * @details Each sub-block is acknowledged once instead of every segment, and the data is
+ * checked with a CRC when the server supports it. The whole transfer must fit in the line
+ * buffer (SDO_MAX_LENGTH_TRANSFER). The function Callback is called at the end of the
+ * exchange (on success or abort); it may be NULL, then use getWriteResultNetworkDict.
+ * @param *d Pointer on a CAN object data structure
+ * @param nodeId Node Id of the slave
+ * @param index At index indicated
+ * @param subIndex At subIndex indicated
+ * @param count number of bytes to write
+ * @param dataType (defined in objdictdef.h) : put "visible_string" for strings, 0 for integers or reals or other value.
+ * @param *data Pointer to data
+ * @param Callback Callback function
+ * @return 
+ * - 0 is returned upon success.
+ * - 0xFE is returned when no sdo client to communicate with node.
+ * - 0xFF is returned when error occurs.
+ */
+UNS8 writeNetworkDictBlockCallback (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subIndex, UNS32 count, UNS8 dataType, void *data, SDOCallback_t Callback);
+
+/** 
+ * @ingroup sdo
+ * @brief Used to read in a distant node dictionnary with a CiA 301 SDO block upload.
+ * @details The server sends sub-blocks of up to 7 * blksize bytes, each acknowledged once, and
+ * a CRC of the data. The object must fit in the line buffer (SDO_MAX_LENGTH_TRANSFER). The
+ * function Callback is called at the end of the exchange (on success or abort); it may be NULL,
+ * then use getReadResultNetworkDict.
+ * @param *d Pointer on a CAN object data structure
+ * @param nodeId Node Id of the slave
+ * @param index At index indicated
+ * @param subIndex At subIndex indicated
+ * @param dataType (defined in objdictdef.h) : put "visible_string" for strings, 0 for integers or reals or other value.
+ * @param Callback Callback function
+ * @return 
+ * - 0 is returned upon success.
+ * - 0xFE is returned when no sdo client to communicate with node.
+ * - 0xFF is returned when error occurs.
+ */
+UNS8 readNetworkDictBlockCallback (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subIndex, UNS8 dataType, SDOCallback_t Callback);
+
 /** 
  * @ingroup sdo
  * @brief Use this function after calling readNetworkDict to get the result.
@@ -95,4 +95,11 @@ void setTimer(TIMEVAL value);
  */
 TIMEVAL getElapsedTime(void);
 
+/**
+ * @ingroup timer
+ * @brief Get the free running time the alarms expire against.
+ * @return current time, wraps around
+ */
+TIMEVAL getCurrentTime(void);
+
 #endif /* #define __timer_h__ */
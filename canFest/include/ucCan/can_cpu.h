@@ -29,6 +29,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 // Canfestivals includes
 #include "can.h"
 
+#define CAN_RX_RING_SIZE 8  //received frames waiting for RunCANServerTask, power of 2 (12 bytes of RAM each)
+#define CAN_TX_QUEUE_SIZE 4  //frames waiting for a TX buffer, in priority order (16 bytes of RAM each)
+#define CAN_TX_WAIT_TICKS 10  //longest wait of canSend for space in a full TX queue before the bus is reset
+
 
 
 /************************* To be called by user app ***************************/
@@ -36,8 +40,13 @@ void canEnable(void);
 void canDisable(void);
 void canInit( void );
 void canReset(void);
+void canUpdateFilter(void);
 //unsigned char canInit(unsigned int bitrate);
 unsigned char canSend(CAN_PORT notused, Message *m);
 unsigned char canReceive(Message *m);
+void canReceiveISR(void);
+UNS8 canTransmitISR(void);
+Message *canReceiveNext(void);
+void canReceiveDone(void);
 
 #endif
@@ -43,7 +43,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 // Needed defines by Canfestival lib
 #define MAX_CAN_BUS_ID 1
 #define SDO_MAX_LENGTH_TRANSFER 50
-#define SDO_MAX_SIMULTANEOUS_TRANSFERS 1
+#define SDO_STAGING_SIZE 0 //server downloads of objects larger than SDO_MAX_LENGTH_TRANSFER are collected here (one at a time), 0: refused. No writable object of ObjDict is larger
+#define SDO_MAX_SIMULTANEOUS_TRANSFERS 3 //client and server lines, one per CAN gateway context (see gatewayPool in gateway.c)
 #define SDO_BLOCK_SIZE 16
 #define NMT_MAX_NODE_ID 127
 #define SDO_TIMEOUT_MS 60U //3500U       //^^^ timeout needs to be shorter than upstream (See CAN_TIMEOUT_TICKS)
@@ -56,7 +57,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //#define US_TO_TIMEVAL_FACTOR 8 
 
 #define REPEAT_SDO_MAX_SIMULTANEOUS_TRANSFERTS_TIMES(repeat)\
-repeat
+repeat repeat repeat
 #define REPEAT_NMT_MAX_NODE_ID_TIMES(repeat)\
 repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat
 
@@ -37,6 +37,8 @@
 #include "lifegrd.h"
 #include "canfestival.h"
 #include "sysdep.h"
+#include "includes.h"
+#include "gateway.h"
 
 /*******************Data*****************************/
 UNS16 serialNumberTable[ACTIVE_NODE_COUNT];
@@ -89,6 +91,7 @@ void ConsumerHearbeatAlarm(CO_Data* d, UNS32 id)
 void processNODE_GUARD(CO_Data* d, Message* m )
 {
   UNS8 nodeId = (UNS8) GET_NODE_ID((*m));
+  e_nodeState previousState;
 
   if((m->rtr == 1) )  // not used by NNP
     /*!
@@ -128,16 +131,24 @@ void processNODE_GUARD(CO_Data* d, Message* m )
       MSG_WAR(0x3110, "Received NMT nodeId : ", nodeId);
       /* the slave's state receievd is stored in the NMTable */
       /* The state is stored on 7 bit */
+      previousState = d->NMTable[nodeId];
       d->NMTable[nodeId] = (e_nodeState) ((*m).data[0] & 0x7F) ;
       
            /* load the Serial Number table   */
       if (serialNumberTable[nodeId] == 0)
         serialNumberTable[nodeId] = (*m).data[1] + (*m).data[2] * 256;
       else if (serialNumberTable[nodeId] != (*m).data[1] + (*m).data[2] * 256)
+      {
         duplicateNode = nodeId;
+        InvalidateCANGatewayCache(nodeId); //different module answering at this node id
+      }
       else
         duplicateNode = 0;
       
+      /* first heartbeat after boot-up/network power on, or node reset: cached OD reads may be stale */
+      if (previousState == Unknown_state || d->NMTable[nodeId] == BootCheckReset)
+        InvalidateCANGatewayCache(nodeId);
+      
       /* check for consumer heartbeat   */
       if( d->NMTable[nodeId] != Unknown_state ) 
       {
@@ -40,6 +40,7 @@ This file is part of CanFestival, a library implementing CanOpen
 #include "SPI_Memory.h"
 #include "sys.h"
 #include "cc1101radio.h"
+#include "gateway.h"
 #include "pwrnet.h"
 #include "can_cfg.h"
 #include "drv_can_reg.h"
@@ -80,6 +81,10 @@ UNS8 masterSendNMTstateChange(CO_Data* d, UNS8 Node_ID, UNS8 cs[3])
   m.data[1] = Node_ID;
   m.data[2] = cs[1];
   m.data[3] = cs[2];
+  
+  if( cs[0] == NMT_Reset_Node || cs[0] == NMT_Reset_Comunication || cs[0] == NMT_Do_Restore_Cmd || 
+      cs[0] == NMT_Enter_Bootloader )
+    InvalidateCANGatewayCache(Node_ID); //0 is broadcast: all nodes
 
   return canSend(d->canHandle,&m);
 }
@@ -181,6 +186,7 @@ void ProcessNMTLocalStateChange(CO_Data* d, UNS8 Data[3] )
   UNS8 Command = Data[0];
   UNS8 Param1   = Data[1];
   UNS8 Param2   = Data[2];
+  UNS8 networkPowerControl = NetworkPowerControl;
   OS_ERR err;
   
   /* Command formatting is slightly different than what exists in the remote modules.
@@ -266,6 +272,7 @@ void ProcessNMTLocalStateChange(CO_Data* d, UNS8 Data[3] )
     if (d->nodeState == Waiting ) // going back to Waiting will turn off Recording
     {           
       TransferBuffer_Counter = 0;
+      ResetHSStream();
       setState(d, Mode_Record_X);          
       RunHighSpeedPassThru(Param1);
       
@@ -733,6 +740,9 @@ void ProcessNMTLocalStateChange(CO_Data* d, UNS8 Data[3] )
     break;
     
   }/* end switch */
+  
+  if (NetworkPowerControl != networkPowerControl)
+    MarkTPDOChanged(&NetworkPowerControl, sizeof(NetworkPowerControl));
 }
 
 
@@ -39,6 +39,7 @@ This file is part of CanFestival, a library implementing CanOpen
 
 
 #include "data.h"
+#include "can_cpu.h"
 
 
 /*!
@@ -209,6 +210,55 @@ UNS32 _getODentry( CO_Data* d,
   }
 }
 
+/*!
+** Work that follows every write of a subindex, shared by _setODentry and writeLocalDictBlock: change of 
+** state TPDOs, compiled PDO mappings, CAN acceptance filter, callback and storage
+**
+** @param d
+** @param wIndex
+** @param bSubindex
+** @param ptrTable
+** @param Callback
+**
+** @return OD_SUCCESSFUL or the error code of the callback
+**/
+static UNS32 ODentryWritten( CO_Data* d,
+                             UNS16 wIndex,
+                             UNS8 bSubindex,
+                             const indextable *ptrTable,
+                             ODCallback_t *Callback)
+{
+  UNS32 errorCode;
+  
+  MarkTPDOChanged(ptrTable->pSubindex[bSubindex].pObject, ptrTable->pSubindex[bSubindex].size);
+
+  /* PDO communication or mapping parameter: compiled PDO mappings are rebuilt */
+  if (wIndex >= 0x1400 && wIndex <= 0x1BFF)
+    InvalidatePDOTables();
+
+  /* SYNC, SDO server, RPDO COB-ID or TPDO COB-ID/transmission type (RTR): the CAN acceptance filter is reprogrammed */
+  if (wIndex == 0x1005 || (wIndex >= 0x1200 && wIndex <= 0x12FF) || 
+      (wIndex >= 0x1400 && wIndex <= 0x15FF) || (wIndex >= 0x1800 && wIndex <= 0x19FF))
+    canUpdateFilter();
+
+  /* Callbacks */
+  if(Callback && Callback[bSubindex])
+  {
+    errorCode = (Callback[bSubindex])(d, ptrTable, bSubindex);
+    if(errorCode != OD_SUCCESSFUL)
+    {
+        return errorCode;
+    }
+  }
+
+  /* TODO : Store dans NVRAM */
+  if (ptrTable->pSubindex[bSubindex].bAccessType & TO_BE_SAVE)
+  {
+    (*d->storeODSubIndex)(d, wIndex, bSubindex);
+  }
+  return OD_SUCCESSFUL;
+}
+
 /*!
 **
 **
@@ -296,23 +346,7 @@ UNS32 _setODentry( CO_Data* d,
         ((UNS8*)ptrTable->pSubindex[bSubindex].pObject)[*pExpectedSize] = 0;
       
       *pExpectedSize = szData;
-
-      /* Callbacks */
-      if(Callback && Callback[bSubindex])
-      {
-        errorCode = (Callback[bSubindex])(d, ptrTable, bSubindex);
-        if(errorCode != OD_SUCCESSFUL)
-        {
-            return errorCode;
-        }
-      }
-
-      /* TODO : Store dans NVRAM */
-      if (ptrTable->pSubindex[bSubindex].bAccessType & TO_BE_SAVE)
-      {
-        (*d->storeODSubIndex)(d, wIndex, bSubindex);
-      }
-      return OD_SUCCESSFUL;
+      return ODentryWritten(d, wIndex, bSubindex, ptrTable, Callback);
     }  // end if (outer IF -- 3rd from top)
   else
   {
@@ -322,6 +356,147 @@ UNS32 _setODentry( CO_Data* d,
     }
 }
 
+/*!
+** Reads nSub consecutive subindexes of one index with a single index lookup and packs them into pDestData
+** in machine native endianness. Each entry takes its OD size; a visible_string stops after its terminating
+** null (or at its OD size).
+**
+** @param d
+** @param wIndex
+** @param bSubindex first subindex
+** @param nSub number of subindexes
+** @param pDestData
+** @param pSize in: size of pDestData, out: number of bytes packed
+** @param checkAccess
+** @param pFailedSub subindex that caused the abort code
+**
+** @return OD_SUCCESSFUL or SDO abort code
+**/
+UNS32 readLocalDictBlock( CO_Data* d,
+                          UNS16 wIndex,
+                          UNS8 bSubindex,
+                          UNS8 nSub,
+                          UNS8 * pDestData,
+                          UNS32 * pSize,
+                          UNS8 checkAccess,
+                          UNS8 * pFailedSub)
+{
+  UNS32 errorCode;
+  UNS32 szData, maxSize = *pSize, packed = 0;
+  const indextable *ptrTable;
+  const subindex *pSub;
+  ODCallback_t *Callback;
+  UNS8 *src;
+
+  *pSize = 0;
+  *pFailedSub = bSubindex;
+  ptrTable = (*d->scanIndexOD)(wIndex, &errorCode, &Callback);
+  if (errorCode != OD_SUCCESSFUL)
+    return errorCode;
+
+  for( ; nSub; nSub--, bSubindex++ )
+  {
+    *pFailedSub = bSubindex;
+    if( ptrTable->bSubCount <= bSubindex ) 
+      return OD_NO_SUCH_SUBINDEX;
+    
+    pSub = &ptrTable->pSubindex[bSubindex];
+    if (checkAccess && (pSub->bAccessType & WO)) 
+      return OD_READ_NOT_ALLOWED;
+    
+    szData = pSub->size;
+    src = (UNS8*)pSub->pObject;
+    if( pSub->bDataType == visible_string )
+    {
+      UNS32 len = 0;
+      while( len < szData && src[len] )
+        len++;
+      szData = (len < szData) ? len + 1 : len; //keep the null as separator
+    }
+    
+    if( packed + szData > maxSize )
+      return SDOABT_OUT_OF_MEMORY;
+    
+    memcpy(pDestData + packed, src, szData);
+    packed += szData;
+    *pSize = packed;
+  }
+  return OD_SUCCESSFUL;
+}
+
+/*!
+** Writes nSub consecutive subindexes of one index with a single index lookup. pSourceData holds the values
+** packed back to back. elemSize is the size of every value (must match the OD size, except a shorter
+** visible_string), or 0 to take each value at its OD size. Range test and the work after each write 
+** (ODentryWritten) are the same as _setODentry; subindexes before a failing one stay written.
+**
+** @param d
+** @param wIndex
+** @param bSubindex first subindex
+** @param nSub number of subindexes
+** @param elemSize
+** @param pSourceData
+** @param sourceSize number of bytes in pSourceData
+** @param checkAccess
+** @param pFailedSub subindex that caused the abort code
+**
+** @return OD_SUCCESSFUL or SDO abort code
+**/
+UNS32 writeLocalDictBlock( CO_Data* d,
+                           UNS16 wIndex,
+                           UNS8 bSubindex,
+                           UNS8 nSub,
+                           UNS8 elemSize,
+                           UNS8 * pSourceData,
+                           UNS32 sourceSize,
+                           UNS8 checkAccess,
+                           UNS8 * pFailedSub)
+{
+  UNS32 errorCode;
+  UNS32 szData, szValue;
+  const indextable *ptrTable;
+  const subindex *pSub;
+  ODCallback_t *Callback;
+
+  *pFailedSub = bSubindex;
+  ptrTable = (*d->scanIndexOD)(wIndex, &errorCode, &Callback);
+  if (errorCode != OD_SUCCESSFUL)
+    return errorCode;
+
+  for( ; nSub; nSub--, bSubindex++ )
+  {
+    *pFailedSub = bSubindex;
+    if( ptrTable->bSubCount <= bSubindex ) 
+      return OD_NO_SUCH_SUBINDEX;
+    
+    pSub = &ptrTable->pSubindex[bSubindex];
+    if (checkAccess && (pSub->bAccessType == RO)) 
+      return OD_WRITE_NOT_ALLOWED;
+    
+    szData = pSub->size;
+    szValue = elemSize ? elemSize : szData;
+    if( szValue > sourceSize )
+      return OD_LENGTH_DATA_INVALID;
+    if( szValue != szData && !(pSub->bDataType == visible_string && szValue < szData) )
+      return OD_LENGTH_DATA_INVALID;
+    
+    errorCode = (*d->valueRangeTest)(pSub->bDataType, pSourceData);
+    if (errorCode) 
+      return errorCode;
+    
+    memcpy(pSub->pObject, pSourceData, szValue);
+    if( szValue < szData ) //shorter visible_string
+      ((UNS8*)pSub->pObject)[szValue] = 0;
+    pSourceData += szValue;
+    sourceSize -= szValue;
+    
+    errorCode = ODentryWritten(d, wIndex, bSubindex, ptrTable, Callback);
+    if(errorCode != OD_SUCCESSFUL)
+      return errorCode;
+  }
+  return OD_SUCCESSFUL;
+}
+
 /*!
 **
 **
@@ -355,7 +530,10 @@ const indextable *odentry;
 
   odentry = scanIndexOD (d, wIndex, &errorCode, &CallbackList);
   if(errorCode == OD_SUCCESSFUL  &&  CallbackList  &&  bSubindex < odentry->bSubCount) 
+  {
     CallbackList[bSubindex] = Callback;
+    InvalidatePDOTables(); //a mapped object with a callback is written through setODentry
+  }
   return errorCode;
 }
 
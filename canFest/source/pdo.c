@@ -29,6 +29,7 @@
 #include "canfestival.h"
 #include "sysdep.h"
 #include "ScriptInterpreter.h"
+#include "gateway.h"
 /*!
 ** @file   pdo.c
 ** @author Edouard TISSERANT and Francis DUPIN
@@ -39,6 +40,324 @@
 **
 */
 UNS32 OnCOB_ID_PDOrx_Update(CO_Data* d, const indextable * unsused_indextable, UNS8 unsused_bSubindex);
+
+/* Compiled PDO mappings ("copy programs"), built from the communication and mapping entries on the first PDO
+ * after InvalidatePDOTables(), which is called when a PDO communication or mapping entry is written and when
+ * callbacks are assigned. Each mapped object is one step: its OD variable, size and bit offset in the frame.
+ * Byte aligned steps are copied with memcpy, others with CopyBits. Objects that must go through setODentry or
+ * getODentry (callback, store, value range type, string, size different from the mapping) are flagged 
+ * PDO_MAP_USE_OD and keep a pointer to their mapping parameter instead. A PDO whose mapping does not fit in 
+ * its pool is processed from the mapping entries as before.
+ * Received PDOs are also found by a COB-ID hash instead of a walk of the RPDO communication entries.
+ * Event driven TPDOs are only rebuilt and compared with the last message when one of their mapped objects was 
+ * written: _setODentry, received PDOs and the writers registered with SetTPDOMarkedObjects() call 
+ * MarkTPDOChanged(). A TPDO mapping any object that is not registered may be written directly by code that does
+ * not mark it, so it is always rebuilt, as are TPDOs that are not compiled or have PDO_MAP_USE_OD steps. */
+#define RPDO_MAX            8   /* 0x1400 to 0x1407 */
+#define TPDO_MAX            8   /* 0x1800 to 0x1807 */
+#define RPDO_HASH_SIZE      16  /* power of 2, > RPDO_MAX */
+#define RPDO_MAP_ENTRIES    16  /* mapped objects over all RPDOs */
+#define TPDO_MAP_ENTRIES    12  /* mapped objects over all TPDOs */
+#define PDO_MAP_USE_OD      0x80
+#define PDO_NOT_COMPILED    0xFF
+#define RPDO_NONE           0xFF
+#define RPDO_HASH(cobId)    (((cobId) ^ ((cobId) >> 4)) & (RPDO_HASH_SIZE - 1))
+
+static UNS8 rpdoTableValid = 0;
+static UNS8 rpdoHash[RPDO_HASH_SIZE];     /* RPDO number or RPDO_NONE */
+static UNS16 rpdoCobId[RPDO_MAX];
+static UNS8 rpdoMapFirst[RPDO_MAX];
+static UNS8 rpdoMapCount[RPDO_MAX];       /* PDO_NOT_COMPILED: use the mapping entries */
+static UNS8 rpdoMapSize[RPDO_MAX];        /* bits, shorter frames use the mapping entries */
+static void * rpdoMapObject[RPDO_MAP_ENTRIES];
+static UNS8 rpdoMapBits[RPDO_MAP_ENTRIES];
+static UNS8 rpdoMapOffset[RPDO_MAP_ENTRIES];
+
+static UNS8 tpdoTableValid = 0;
+static UNS8 tpdoMapFirst[TPDO_MAX];
+static UNS8 tpdoMapCount[TPDO_MAX];
+static void * tpdoMapObject[TPDO_MAP_ENTRIES];
+static UNS8 tpdoMapBits[TPDO_MAP_ENTRIES];
+static UNS8 tpdoMapOffset[TPDO_MAP_ENTRIES];
+static UNS8 tpdoDirty = 0xFF;             /* bit n: TPDO n has a mapped object written since it was last built */
+static UNS8 tpdoAlwaysBuild = 0xFF;       /* bit n: TPDO n is rebuilt on every event */
+static const s_TPDO_marked_object *tpdoMarkedObjects = NULL;
+static UNS8 tpdoMarkedCount = 0;
+
+/*!
+** Marks the compiled PDO mappings and the received PDO lookup for rebuilding before the next PDO
+**/
+void InvalidatePDOTables (void)
+{
+  rpdoTableValid = 0;
+  tpdoTableValid = 0;
+}
+
+/*!
+** Registers the OD variables whose writers call MarkTPDOChanged()
+**
+** @param objects
+** @param count
+**/
+void SetTPDOMarkedObjects (const s_TPDO_marked_object * objects, UNS8 count)
+{
+  tpdoMarkedObjects = objects;
+  tpdoMarkedCount = count;
+  tpdoTableValid = 0;
+}
+
+/*!
+** Tests if a compiled TPDO step lies in a registered variable
+**
+** @param pStep
+** @param bits
+**
+** @return 1 if a write to the step is marked
+**/
+static UNS8 isTPDOStepMarked (const void * pStep, UNS8 bits)
+{
+  const UNS8 *pStart = (const UNS8 *) pStep;
+  const UNS8 *pObject;
+  UNS8 i;
+
+  for (i = 0; i < tpdoMarkedCount; i++)
+    {
+      pObject = (const UNS8 *) tpdoMarkedObjects[i].pObject;
+      if (pObject <= pStart && pStart + ((bits + 7) >> 3) <= pObject + tpdoMarkedObjects[i].size)
+        return 1;
+    }
+  return 0;
+}
+
+/*!
+** Compiles one mapping entry into step nMap of a copy program
+**
+** @param d
+** @param pMappingParameter
+** @param offset bit offset of the object in the frame
+** @param isTPDO
+** @param pObject, pBits, pOffset step arrays
+**/
+static void compilePDOStep (CO_Data * d, UNS32 * pMappingParameter, UNS8 offset, UNS8 isTPDO,
+                            void ** pObject, UNS8 * pBits, UNS8 * pOffset)
+{
+  const indextable *ptrTable;
+  ODCallback_t *Callback;
+  UNS32 errorCode;
+  UNS8 Size = (UNS8) (*pMappingParameter & (UNS32) 0x000000FF);
+  UNS8 subIndex = (UNS8) ((*pMappingParameter >> 8) & 0xFF);
+  const subindex *entry;
+
+  *pOffset = offset;
+  ptrTable = (*d->scanIndexOD)((UNS16) (*pMappingParameter >> 16), &errorCode, &Callback);
+  if (errorCode == OD_SUCCESSFUL && subIndex < ptrTable->bSubCount)
+    {
+      entry = &ptrTable->pSubindex[subIndex];
+      if (entry->size == (UNS32)(1 + ((Size - 1) >> 3))
+          && entry->bDataType < pdo_communication_parameter && entry->bDataType != visible_string
+          && (isTPDO || (!(entry->bAccessType & TO_BE_SAVE) && !(Callback && Callback[subIndex]))))
+        {
+          *pObject = entry->pObject;
+          *pBits = Size;
+          return;
+        }
+    }
+  *pObject = pMappingParameter;
+  *pBits = Size | PDO_MAP_USE_OD;
+}
+
+/*!
+**
+**
+** @param d
+**/
+static void buildRPDOTable (CO_Data * d)
+{
+  UNS16 offsetObjdict = d->firstIndex->PDO_RCV;
+  UNS16 lastIndex = d->lastIndex->PDO_RCV;
+  const indextable *mapTable;
+  UNS32 *pMappingParameter;
+  UNS32 cobId;
+  UNS8 numPdo, numMap, h, nMap = 0;
+  UNS8 Size, offset;
+
+  memset (rpdoHash, RPDO_NONE, sizeof (rpdoHash));
+  rpdoTableValid = 1;
+  if (offsetObjdict == 0)
+    return;
+
+  for (numPdo = 0; numPdo < RPDO_MAX && offsetObjdict + numPdo <= lastIndex; numPdo++)
+    {
+      cobId = *(UNS32 *) d->objdict[offsetObjdict + numPdo].pSubindex[1].pObject;
+      if (cobId > 0x7FF)        /* not valid */
+        continue;
+
+      /* the first RPDO with a COB-ID receives it */
+      h = RPDO_HASH (cobId);
+      while (rpdoHash[h] != RPDO_NONE && rpdoCobId[rpdoHash[h]] != cobId)
+        h = (h + 1) & (RPDO_HASH_SIZE - 1);
+      if (rpdoHash[h] != RPDO_NONE)
+        continue;
+      rpdoHash[h] = numPdo;
+      rpdoCobId[numPdo] = (UNS16) cobId;
+
+      mapTable = d->objdict + d->firstIndex->PDO_RCV_MAP + numPdo;
+      rpdoMapFirst[numPdo] = nMap;
+      rpdoMapCount[numPdo] = 0;
+      offset = 0;
+      for (numMap = 0; numMap < *(UNS8 *) mapTable->pSubindex[0].pObject; numMap++)
+        {
+          pMappingParameter = (UNS32 *) mapTable->pSubindex[numMap + 1].pObject;
+          if (pMappingParameter == NULL || nMap >= RPDO_MAP_ENTRIES)
+            {
+              rpdoMapCount[numPdo] = PDO_NOT_COMPILED;
+              nMap = rpdoMapFirst[numPdo];
+              break;
+            }
+          Size = (UNS8) (*pMappingParameter & (UNS32) 0x000000FF);
+          if (Size == 0 || offset + Size > 64)   /* never set by a full frame */
+            continue;
+          compilePDOStep (d, pMappingParameter, offset, 0, &rpdoMapObject[nMap], &rpdoMapBits[nMap], &rpdoMapOffset[nMap]);
+          offset += Size;
+          nMap++;
+          rpdoMapCount[numPdo]++;
+        }
+      rpdoMapSize[numPdo] = offset;
+    }
+}
+
+/*!
+**
+**
+** @param d
+**/
+static void buildTPDOTable (CO_Data * d)
+{
+  UNS16 offsetObjdict = d->firstIndex->PDO_TRS;
+  UNS16 lastIndex = d->lastIndex->PDO_TRS;
+  const indextable *mapTable;
+  UNS32 *pMappingParameter;
+  UNS8 numPdo, numMap, nMap = 0;
+  UNS8 Size, offset;
+
+  tpdoTableValid = 1;
+  tpdoAlwaysBuild = 0;
+  memset (tpdoMapCount, 0, sizeof (tpdoMapCount));
+  if (offsetObjdict == 0)
+    return;
+
+  for (numPdo = 0; numPdo < TPDO_MAX && offsetObjdict + numPdo <= lastIndex; numPdo++)
+    {
+      mapTable = d->objdict + d->firstIndex->PDO_TRS_MAP + numPdo;
+      tpdoMapFirst[numPdo] = nMap;
+      tpdoMapCount[numPdo] = 0;
+      offset = 0;
+      for (numMap = 0; numMap < *(UNS8 *) mapTable->pSubindex[0].pObject; numMap++)
+        {
+          pMappingParameter = (UNS32 *) mapTable->pSubindex[numMap + 1].pObject;
+          if (nMap >= TPDO_MAP_ENTRIES)
+            {
+              tpdoMapCount[numPdo] = PDO_NOT_COMPILED;
+              nMap = tpdoMapFirst[numPdo];
+              break;
+            }
+          Size = (UNS8) (*pMappingParameter & (UNS32) 0x000000FF);
+          if (Size == 0 || offset + Size > 64)   /* skipped by buildPDO */
+            continue;
+          compilePDOStep (d, pMappingParameter, offset, 1, &tpdoMapObject[nMap], &tpdoMapBits[nMap], &tpdoMapOffset[nMap]);
+          if ((tpdoMapBits[nMap] & PDO_MAP_USE_OD) || !isTPDOStepMarked (tpdoMapObject[nMap], tpdoMapBits[nMap]))
+            tpdoAlwaysBuild |= 1 << numPdo;
+          offset += Size;
+          nMap++;
+          tpdoMapCount[numPdo]++;
+        }
+      if (tpdoMapCount[numPdo] == PDO_NOT_COMPILED)
+        tpdoAlwaysBuild |= 1 << numPdo;
+    }
+  tpdoDirty = 0xFF;             /* after the steps, so a write during the build is not lost */
+}
+
+/*!
+** Marks the TPDOs that map any part of an object for rebuilding on their next event
+**
+** @param pObject OD variable that was written
+** @param size in bytes
+**/
+void MarkTPDOChanged (const void * pObject, UNS32 size)
+{
+  UNS8 numPdo, k, mask = 0;
+  const UNS8 *pStart = (const UNS8 *) pObject;
+  const UNS8 *pStep;
+
+  if (!tpdoTableValid)          /* all are dirty after the build */
+    return;
+  for (numPdo = 0; numPdo < TPDO_MAX; numPdo++)
+    {
+      if (tpdoMapCount[numPdo] == PDO_NOT_COMPILED)
+        continue;
+      for (k = tpdoMapFirst[numPdo]; k < tpdoMapFirst[numPdo] + tpdoMapCount[numPdo]; k++)
+        {
+          pStep = (const UNS8 *) tpdoMapObject[k];
+          if (!(tpdoMapBits[k] & PDO_MAP_USE_OD)
+              && pStep < pStart + size && pStart < pStep + ((tpdoMapBits[k] + 7) >> 3))
+            {
+              mask |= 1 << numPdo;
+              break;
+            }
+        }
+    }
+  if (mask)
+    {
+      CPU_SR_ALLOC();
+      CPU_CRITICAL_ENTER();
+      tpdoDirty |= mask;
+      CPU_CRITICAL_EXIT();
+    }
+}
+
+/*!
+** Tests and clears the dirty bit of a TPDO
+**
+** @param d
+** @param numPdo
+**
+** @return 1 if the TPDO must be rebuilt
+**/
+static UNS8 takeTPDODirty (CO_Data * d, UNS8 numPdo)
+{
+  UNS8 dirty;
+  CPU_SR_ALLOC();
+
+  if (!tpdoTableValid)
+    buildTPDOTable (d);
+  if (numPdo >= TPDO_MAX)
+    return 1;
+  CPU_CRITICAL_ENTER();
+  dirty = (tpdoDirty | tpdoAlwaysBuild) & (1 << numPdo);
+  tpdoDirty &= ~(1 << numPdo);
+  CPU_CRITICAL_EXIT();
+  return dirty != 0;
+}
+
+/*!
+**
+**
+** @param cobId
+**
+** @return RPDO number or RPDO_NONE
+**/
+static UNS8 findRPDO (UNS16 cobId)
+{
+  UNS8 h = RPDO_HASH (cobId);
+
+  while (rpdoHash[h] != RPDO_NONE)
+    {
+      if (rpdoCobId[rpdoHash[h]] == cobId)
+        return rpdoHash[h];
+      h = (h + 1) & (RPDO_HASH_SIZE - 1);
+    }
+  return RPDO_NONE;
+}
 /*!
 **
 **
@@ -65,6 +384,48 @@ UNS8 buildPDO (CO_Data * d, UNS8 numPdo, Message * pdo)
            *(UNS32 *) TPDO_com->pSubindex[1].pObject);
   MSG_WAR (0x300D, "  Number of objects mapped : ", *pMappingCount);
 
+  if (!tpdoTableValid)
+    buildTPDOTable (d);
+  if (numPdo < TPDO_MAX && tpdoMapCount[numPdo] != PDO_NOT_COMPILED)
+    {
+      UNS8 k, Size;
+      for (k = tpdoMapFirst[numPdo]; k < tpdoMapFirst[numPdo] + tpdoMapCount[numPdo]; k++)
+        {
+          Size = tpdoMapBits[k] & ~PDO_MAP_USE_OD;
+          offset = tpdoMapOffset[k];
+          if (tpdoMapBits[k] & PDO_MAP_USE_OD)
+            {
+              UNS8 dataType;
+              UNS8 tmp[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+              UNS32 ByteSize = 1 + ((Size - 1) >> 3);
+              UNS32 *pMappingParameter = (UNS32 *) tpdoMapObject[k];
+
+              if (getODentry (d, (UNS16) ((*pMappingParameter) >> 16), (UNS8) (((*pMappingParameter) >> 8) & 0xFF),
+                              tmp, &ByteSize, &dataType, 0) != OD_SUCCESSFUL)
+                {
+                  MSG_ERR (0x1013,
+                           " Couldn't find mapped variable at index-subindex-size : ",
+                           (UNS16) (*pMappingParameter));
+                  return 0xFF;
+                }
+              CopyBits (Size, ((UNS8 *) tmp), 0, 0,
+                        (UNS8 *) & pdo->data[offset >> 3], (UNS8)(offset % 8), 0);
+            }
+          else if (((offset | Size) & 7) == 0)    /* byte aligned */
+            {
+              memcpy (&pdo->data[offset >> 3], tpdoMapObject[k], Size >> 3);
+            }
+          else
+            {
+              CopyBits (Size, (UNS8 *) tpdoMapObject[k], 0, 0,
+                        (UNS8 *) & pdo->data[offset >> 3], (UNS8)(offset % 8), 0);
+            }
+          offset += Size;
+        }
+      pdo->len = (UNS8)(1 + ((offset - 1) >> 3));
+      return 0;
+    }
+
   do
     {
       UNS8 dataType;            /* Unused */
@@ -136,7 +497,7 @@ UNS32 OnCOB_ID_PDOrx_Update(CO_Data* d, const indextable * OD_entry, UNS8 unsuse
     status = getODentry( d,  wIndex , 4, &scriptPointer, &pdoSize, &type, 0);
     if (scriptPointer)
     {
-      AddScriptToQueue( scriptPointer );
+      AddScriptToQueue( scriptPointer, SCRIPT_TRIGGER_RPDO );
     }
   }
   else    
@@ -236,115 +597,118 @@ UNS8 processPDO (CO_Data * d, Message * m)
   if ((*m).rtr == NOT_A_REQUEST)
     {                           /* The PDO received is not a
                                    request. */
+      if (!rpdoTableValid)
+        buildRPDOTable (d);
+      numPdo = findRPDO (UNS16_LE(m->cob_id));
+      if (numPdo == RPDO_NONE)
+        return 0;
+      wIndex = 0x1400 + numPdo;
+
+      if (rpdoMapCount[numPdo] != PDO_NOT_COMPILED && rpdoMapSize[numPdo] <= (m->len << 3))
+        {
+          UNS8 k;
+          for (k = rpdoMapFirst[numPdo]; k < rpdoMapFirst[numPdo] + rpdoMapCount[numPdo]; k++)
+            {
+              UNS8 tmp[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+              UNS32 ByteSize;
 
-      offsetObjdict = d->firstIndex->PDO_RCV;
-      lastIndex = d->lastIndex->PDO_RCV;
-
-      /* study of all the PDO stored in the dictionary */
-      if (offsetObjdict)
-        while (offsetObjdict <= lastIndex)
-          {
-            switch (status)
-              {
-
-              case state2:
-                /* get CobId of the dictionary correspondant to the received
-                   PDO */
-                pwCobId =
-                  d->objdict[offsetObjdict].pSubindex[1].pObject;
-                /* check the CobId coherance */
-                /*pwCobId is the cobId read in the dictionary at the state 3
-                 */
-                if (*pwCobId == UNS16_LE(m->cob_id))
-                  {
-                    /* The cobId is recognized */
-                    wIndex = 0x1400 + numPdo;
-                    status = state4;
-                    break;
-                  }
-                else
-                  {
-                    /* cobId received does not match this entry in the
-                       dictionary */
-                    numPdo++;
-                    offsetObjdict++;
-                    status = state2;
-                    break;
-                  }
-
-              case state4:     /* Get Mapped Objects Number */
-                /* The cobId of the message received has been found in the
-                   dictionnary. */
-                offsetObjdict = d->firstIndex->PDO_RCV_MAP; // locate the MAP
-                lastIndex = d->lastIndex->PDO_RCV_MAP;
-                pMappingCount =
-                  (UNS8 *) (d->objdict + offsetObjdict +
-                            numPdo)->pSubindex[0].pObject;
-                numMap = 0;
-                while (numMap < *pMappingCount)
+              Size = rpdoMapBits[k] & ~PDO_MAP_USE_OD;
+              offset = rpdoMapOffset[k];
+              ByteSize = (UNS32)(1 + ((Size - 1) >> 3));
+              if (rpdoMapBits[k] & PDO_MAP_USE_OD)
+                {
+                  pMappingParameter = (UNS32 *) rpdoMapObject[k];
+                  CopyBits (Size, (UNS8 *) & m->data[offset >> 3], offset % 8, 0, ((UNS8 *) tmp), 0, 0);
+                  objDict =
+                    setODentry (d, (UNS16) ((*pMappingParameter) >> 16),
+                                (UNS8) (((*pMappingParameter) >> 8) & 0xFF), tmp, &ByteSize, 0);
+                  if (objDict != OD_SUCCESSFUL)
+                    return 0xFF;
+                }
+              else if (((offset | Size) & 7) == 0)    /* byte aligned */
+                {
+                  memcpy (rpdoMapObject[k], &m->data[offset >> 3], ByteSize);
+                }
+              else
+                {
+                  CopyBits (Size, (UNS8 *) & m->data[offset >> 3], offset % 8, 0, ((UNS8 *) tmp), 0, 0);
+                  memcpy (rpdoMapObject[k], tmp, ByteSize);
+                }
+              if (!(rpdoMapBits[k] & PDO_MAP_USE_OD))   /* setODentry marks its own */
+                MarkTPDOChanged (rpdoMapObject[k], ByteSize);
+            }
+        }
+      else
+        {
+          /* mapping not compiled or frame shorter than the mapping */
+          offset = 0;
+          offsetObjdict = d->firstIndex->PDO_RCV_MAP; // locate the MAP
+          pMappingCount =
+            (UNS8 *) (d->objdict + offsetObjdict +
+                      numPdo)->pSubindex[0].pObject;
+          numMap = 0;
+          while (numMap < *pMappingCount)
+            {
+              UNS8 tmp[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+              UNS32 ByteSize;
+              pMappingParameter =
+                (UNS32 *) (d->objdict + offsetObjdict +
+                           numPdo)->pSubindex[numMap + 1].pObject;
+              if (pMappingParameter == NULL)
+                {
+                  MSG_ERR (0x1937, "Couldn't get mapping parameter : ",
+                           numMap + 1);
+                  return 0xFF;
+                }
+              /* Get the addresse of the mapped variable. */
+              /* detail of *pMappingParameter : */
+              /* The 16 high bits contains the index, the medium 8 bits
+                 contains the subindex, */
+              /* and the lower 8 bits contains the size of the mapped
+                 variable. */
+
+              Size = (UNS8) (*pMappingParameter & (UNS32) 0x000000FF);
+
+              /* set variable only if Size != 0 and 
+               * Size is lower than remaining bits in the PDO */
+              if (Size && ((offset + Size) <= (m->len << 3)))
+                {
+                  /* copy bit per bit in little endian */
+                  CopyBits (Size, (UNS8 *) & m->data[offset >> 3],
+                            offset % 8, 0, ((UNS8 *) tmp), 0, 0);
+                  /*1->8 => 1 ; 9->16 =>2, ... */
+                  ByteSize = (UNS32)(1 + ((Size - 1) >> 3));
+                  /* setODentry sets bits in OD and also executes the callback */
+                  objDict =
+                    setODentry (d, (UNS16) ((*pMappingParameter) >> 16),
+                                (UNS8) (((*pMappingParameter) >> 8) &
+                                        0xFF), tmp, &ByteSize, 0);                        
+
+                  if (objDict != OD_SUCCESSFUL)
                   {
-                    UNS8 tmp[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-                    UNS32 ByteSize;
-                    pMappingParameter =
-                      (UNS32 *) (d->objdict + offsetObjdict +
-                                 numPdo)->pSubindex[numMap + 1].pObject;
-                    if (pMappingParameter == NULL)
-                      {
-                        MSG_ERR (0x1937, "Couldn't get mapping parameter : ",
-                                 numMap + 1);
-                        return 0xFF;
-                      }
-                    /* Get the addresse of the mapped variable. */
-                    /* detail of *pMappingParameter : */
-                    /* The 16 high bits contains the index, the medium 8 bits
-                       contains the subindex, */
-                    /* and the lower 8 bits contains the size of the mapped
-                       variable. */
-
-                    Size = (UNS8) (*pMappingParameter & (UNS32) 0x000000FF);
-
-                    /* set variable only if Size != 0 and 
-                     * Size is lower than remaining bits in the PDO */
-                    if (Size && ((offset + Size) <= (m->len << 3)))
-                      {
-                        /* copy bit per bit in little endian */
-                        CopyBits (Size, (UNS8 *) & m->data[offset >> 3],
-                                  offset % 8, 0, ((UNS8 *) tmp), 0, 0);
-                        /*1->8 => 1 ; 9->16 =>2, ... */
-                        ByteSize = (UNS32)(1 + ((Size - 1) >> 3));
-                        /* setODentry sets bits in OD and also executes the callback */
-                        objDict =
-                          setODentry (d, (UNS16) ((*pMappingParameter) >> 16),
-                                      (UNS8) (((*pMappingParameter) >> 8) &
-                                              0xFF), tmp, &ByteSize, 0);                        
-
-                        if (objDict != OD_SUCCESSFUL)
-                        {
-                            return 0xFF;
-                        }                    
-                        offset += Size;
-                      }
-                    numMap++;
-                  }  /* end loop while on mapped variables */
+                      return 0xFF;
+                  }                    
+                  offset += Size;
+                }
+              numMap++;
+            }  /* end loop while on mapped variables */
+        }
                 
-                         /* Callbacks - added to pdo for pdo processing tied to PDO structure*/
-                         /* first get pointer table reference */
-                 ptrTable =(*d->scanIndexOD)(wIndex, &errorCode, &Callback);
-                 if (errorCode != OD_SUCCESSFUL)
-                   return errorCode;
-                        
-                 if(Callback && Callback[1]) // assigned in PDOInit()
-                 {
-                    errorCode = (Callback[1])(d, ptrTable, 1);
-                    if(errorCode != OD_SUCCESSFUL)
-                    {
-                        return errorCode;
-                    }
-                 }
-                return 0;
-
-              }                 /* end switch status */
-          }                     /* end while */
+      /* Callbacks - added to pdo for pdo processing tied to PDO structure*/
+      /* first get pointer table reference */
+      ptrTable =(*d->scanIndexOD)(wIndex, &errorCode, &Callback);
+      if (errorCode != OD_SUCCESSFUL)
+        return errorCode;
+             
+      if(Callback && Callback[1]) // assigned in PDOInit()
+      {
+         errorCode = (Callback[1])(d, ptrTable, 1);
+         if(errorCode != OD_SUCCESSFUL)
+         {
+             return errorCode;
+         }
+      }
+      return 0;
     }                           /* end if Donnees */
   else if ((*m).rtr == REQUEST)
     {
@@ -455,6 +819,7 @@ UNS8 processPDO (CO_Data * d, Message * m)
 UNS8 processHSPDO (CO_Data * d, Message * m)
 {
   UNS8 index;
+  UNS8 filled = 0;
   CPU_SR_ALLOC();
   
   CPU_CRITICAL_ENTER();
@@ -468,6 +833,10 @@ UNS8 processHSPDO (CO_Data * d, Message * m)
       
       memcpy(&TransferBuffer_Copy[0], &TransferBuffer_Working[0], sizeof(TransferBuffer_Working));
       TransferBuffer_Flag = 1;
+      if (TransferBuffer_StreamMode)
+      {
+        filled = QueueHSStream(TransferBuffer_Copy, TransferBuffer_RadioCounter);
+      }
       TransferBuffer_RadioCounter++;
       
     
@@ -477,10 +846,16 @@ UNS8 processHSPDO (CO_Data * d, Message * m)
       TransferBuffer_Counter += 8;
     }
   CPU_CRITICAL_EXIT();    
+  
+  if (filled)
+    WakeHSStream(); //radio task sends the queued buffer
   return 0;
 }
 /*!
-**
+** Copies NbBits from SrcByteIndex/SrcBitIndex to DestByteIndex/DestBitIndex, LSB first. A big endian side 
+** walks its bytes downwards. Works on up to 24 bits at a time: the bytes holding them are gathered into a 
+** 32 bit word, shifted into place and merged with the destination word under a mask. Only the bytes that 
+** hold copied bits are read or written.
 **
 ** @param NbBits
 ** @param SrcByteIndex
@@ -494,55 +869,41 @@ void CopyBits (UNS8 NbBits, UNS8 * SrcByteIndex, UNS8 SrcBitIndex,
           UNS8 SrcBigEndian, UNS8 * DestByteIndex, UNS8 DestBitIndex,
           UNS8 DestBigEndian)
 {
-  /* This loop copy as many bits that it can each time, crossing */
-  /* successively bytes */
-  // boundaries from LSB to MSB.
+  INTEGER8 SrcStep = SrcBigEndian ? -1 : 1;
+  INTEGER8 DestStep = DestBigEndian ? -1 : 1;
+
   while (NbBits > 0)
     {
-      /* Bit missalignement between src and dest */
-      INTEGER8 Vect = DestBitIndex - SrcBitIndex;
-
-      /* We can now get src and align it to dest */
-      UNS8 Aligned =
-        Vect > 0 ? *SrcByteIndex << Vect : *SrcByteIndex >> -Vect;
+      UNS8 BitsToCopy = NbBits > 24 ? 24 : NbBits;
+      UNS8 SrcBytes = (UNS8)((SrcBitIndex + BitsToCopy + 7) >> 3);
+      UNS8 DestBytes = (UNS8)((DestBitIndex + BitsToCopy + 7) >> 3);
+      UNS32 Mask = (((UNS32) 1 << BitsToCopy) - 1);
+      UNS32 Word = 0;
+      UNS32 DestWord = 0;
+      UNS8 i;
+
+      /* gather the source bits */
+      for (i = 0; i < SrcBytes; i++)
+        Word |= (UNS32) SrcByteIndex[i * SrcStep] << (i << 3);
+      Word = (Word >> SrcBitIndex) & Mask;
+
+      /* merge them into the destination */
+      for (i = 0; i < DestBytes; i++)
+        DestWord |= (UNS32) DestByteIndex[i * DestStep] << (i << 3);
+      DestWord = (DestWord & ~(Mask << DestBitIndex)) | (Word << DestBitIndex);
+      for (i = 0; i < DestBytes; i++)
+        DestByteIndex[i * DestStep] = (UNS8) (DestWord >> (i << 3));
+
+      /* next cursors */
+      SrcBitIndex += BitsToCopy;
+      SrcByteIndex += (SrcBitIndex >> 3) * SrcStep;
+      SrcBitIndex &= 7;
+      DestBitIndex += BitsToCopy;
+      DestByteIndex += (DestBitIndex >> 3) * DestStep;
+      DestBitIndex &= 7;
 
-      /* Compute the nb of bit we will be able to copy */
-      UNS8 BoudaryLimit = (Vect > 0 ? 8 - DestBitIndex : 8 - SrcBitIndex);
-      UNS8 BitsToCopy = BoudaryLimit > NbBits ? NbBits : BoudaryLimit;
-
-      /* Create a mask that will serve in: */
-      UNS8 Mask =
-        ((0xff << (DestBitIndex + BitsToCopy)) |
-         (0xff >> (8 - DestBitIndex)));
-
-      /* - Filtering src */
-      UNS8 Filtered = Aligned & ~Mask;
-
-      /* - and erase bits where we write, preserve where we don't */
-      *DestByteIndex &= Mask;
-
-      /* Then write. */
-      *DestByteIndex |= Filtered;
-
-      /*Compute next time cursors for src */
-      if ((SrcBitIndex += BitsToCopy) > 7)      /* cross boundary ? */
-        {
-          SrcBitIndex = 0;      /* First bit */
-          SrcByteIndex += (SrcBigEndian ? -1 : 1);      /* Next byte */
-        }
-
-
-      /*Compute next time cursors for dest */
-      if ((DestBitIndex += BitsToCopy) > 7)
-        {
-          DestBitIndex = 0;     /* First bit */
-          DestByteIndex += (DestBigEndian ? -1 : 1);    /* Next byte */
-        }
-
-      /*And decrement counter. */
       NbBits -= BitsToCopy;
     }
-
 }
 
 static void sendPdo(CO_Data * d, UNS32 pdoNum, Message * pdo)
@@ -580,6 +941,13 @@ UNS8 sendOnePDOevent (CO_Data * d, UNS8 pdoNum)
       return 0;
     }
 
+  /* nothing mapped was written since the last build: the PDO cannot have changed, unless the 
+     emission is forced by clearing the last message */
+  if (!takeTPDODirty (d, pdoNum) && d->PDO_status[pdoNum].last_message.cob_id != 0)
+    {
+      return 0;
+    }
+
   offsetObjdict = (UNS16) (d->firstIndex->PDO_TRS + pdoNum);
 
   MSG_WAR (0x3968, "  PDO is on EVENT. Trans type : ",
@@ -865,6 +1233,8 @@ void PDOInit (CO_Data * d)
       offsetObjdict++;
     }
   
+  InvalidatePDOTables ();       /* callbacks change which mapped objects need setODentry */
+  
   // now register RPDO's for callbacks
   pdoIndex = 0x1400;      /* OD index of RDPO */
   offsetObjdict = d->firstIndex->PDO_RCV;;
@@ -34,8 +34,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 /* #define DEBUG_WAR_CONSOLE_ON */
 /* #define DEBUG_ERR_CONSOLE_ON */
 
+#include "includes.h"
 #include "canfestival.h"
 #include "sysdep.h"
+#include "gateway.h"
 
 /* Uncomment if your compiler does not support inline functions */
 #define NO_INLINE
@@ -122,13 +124,20 @@ INLINE UNS8 _readNetworkDict (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subInde
 #define getSDOsubIndex(byte3) (byte3)
 
 /*!
-**
+** Runs in RunCANTimerTask, which preempts the CAN server task and the gateway contexts: the line is only
+** touched with the SDO lines locked, and is left alone if it was closed or its timer stopped meanwhile
 **
 ** @param d
 ** @param id
 **/
 void SDOTimeoutAlarm(CO_Data* d, UNS32 id)
 {
+    LockSDOLines();
+    if (d->transfers[id].state == SDO_RESET || d->transfers[id].timer == TIMER_NONE)
+    {
+        UnlockSDOLines();
+        return;
+    }
     MSG_ERR(0x1A01, "SDO timeout. SDO response not received.", 0);
     MSG_WAR(0x2A02, "server node : ", d->transfers[id].nodeId);
     MSG_WAR(0x2A02, "      index : ", d->transfers[id].index);
@@ -148,6 +157,7 @@ void SDOTimeoutAlarm(CO_Data* d, UNS32 id)
     else if(d->transfers[id].whoami == SDO_SERVER)
     	/*Else, if server, reset the line*/
     	resetSDOline(d, (UNS8)id);
+    UnlockSDOLines();
 }
 
 #define StopSDO_TIMER(id) \
@@ -176,6 +186,112 @@ void resetSDO (CO_Data* d)
       resetSDOline(d, j);
 }
 
+/* Server downloads of objects larger than data[] are collected in sdoStaging and written to the dictionary by
+   SDOlineToObjdict once the transfer is complete and checked (size, block CRC, then the range test of setODentry),
+   so an aborted or rejected download leaves the object unchanged.  One line holds the staging area at a time.
+   Without it (SDO_STAGING_SIZE 0) such downloads are refused with SDOABT_OUT_OF_MEMORY */
+#if SDO_STAGING_SIZE > 0
+static UNS8 sdoStaging[SDO_STAGING_SIZE];
+static s_transfer *sdoStagingOwner = NULL;
+#endif
+
+/*!
+** Points the line at the OD object of its index and subIndex, so that segments are
+** read from the object without going through data[] (downloads only take its size).
+** Strings are left to the copy, their size depends on the content. The object is
+** copied as is, so this is not used when the data has to be endianized.
+**
+** @param d
+** @param line
+** @param write
+**
+** @return
+**/
+static UNS32 referenceODentry (CO_Data* d, UNS8 line, UNS8 write)
+{
+#ifndef CANOPEN_BIG_ENDIAN
+  UNS32 errorCode;
+  const indextable *ptrTable;
+  ODCallback_t *Callback;
+  UNS8 subIndex = d->transfers[line].subIndex;
+
+  ptrTable = (*d->scanIndexOD)(d->transfers[line].index, &errorCode, &Callback);
+  if (errorCode != OD_SUCCESSFUL)
+    return errorCode;
+  if (ptrTable->bSubCount <= subIndex)
+    return OD_NO_SUCH_SUBINDEX;
+  if (write && ptrTable->pSubindex[subIndex].bAccessType == RO)
+    return OD_WRITE_NOT_ALLOWED;
+  if (!write && (ptrTable->pSubindex[subIndex].bAccessType & WO))
+    return OD_READ_NOT_ALLOWED;
+  if (ptrTable->pSubindex[subIndex].bDataType == visible_string)
+    return 0;
+  d->transfers[line].pObject = (UNS8*)ptrTable->pSubindex[subIndex].pObject;
+  d->transfers[line].objectSize = ptrTable->pSubindex[subIndex].size;
+#endif
+  return 0;
+}
+
+/*!
+** Server download: objects larger than data[] are collected in sdoStaging, the others in data[].
+** Either way the dictionary is written when the transfer is complete (SDOlineToObjdict).
+**
+** @param d
+** @param line
+**
+** @return
+**/
+static UNS32 prepareSDOdownload (CO_Data* d, UNS8 line)
+{
+  UNS32 errorCode;
+
+  errorCode = referenceODentry(d, line, 1);
+  if (errorCode != OD_SUCCESSFUL)
+    return errorCode;
+  if (d->transfers[line].objectSize <= SDO_MAX_LENGTH_TRANSFER) {
+    d->transfers[line].pObject = NULL;
+    d->transfers[line].objectSize = 0;
+    return 0;
+  }
+#if SDO_STAGING_SIZE > 0
+  if (d->transfers[line].objectSize <= SDO_STAGING_SIZE &&
+      (sdoStagingOwner == NULL || sdoStagingOwner == &d->transfers[line])) {
+    sdoStagingOwner = &d->transfers[line];
+    d->transfers[line].pObject = sdoStaging;
+    return 0;
+  }
+#endif
+  d->transfers[line].pObject = NULL;
+  d->transfers[line].objectSize = 0;
+  return SDOABT_OUT_OF_MEMORY;
+}
+
+/*!
+** Bytes the line can hold: the object it references, else data[]
+**
+** @param d
+** @param line
+**
+** @return
+**/
+static UNS32 lineCapacity (CO_Data* d, UNS8 line)
+{
+  return d->transfers[line].pObject ? d->transfers[line].objectSize : SDO_MAX_LENGTH_TRANSFER;
+}
+
+/*!
+**
+**
+** @param d
+** @param line
+**
+** @return
+**/
+static UNS8* lineData (CO_Data* d, UNS8 line)
+{
+  return d->transfers[line].pObject ? d->transfers[line].pObject : d->transfers[line].data;
+}
+
 /*!
 **
 **
@@ -193,8 +309,13 @@ UNS32 SDOlineToObjdict (CO_Data* d, UNS8 line)
   if( d->transfers[line].count == 0)
   	d->transfers[line].count = d->transfers[line].offset;
   size = d->transfers[line].count;
+  /* setODentry checks size and range before it copies from data[] or sdoStaging */
   errorCode = setODentry(d, d->transfers[line].index, d->transfers[line].subIndex,
-			 (void *) d->transfers[line].data, &size, 1);
+			 (void *) lineData(d, line), &size, 1);
+#if SDO_STAGING_SIZE > 0
+  if (sdoStagingOwner == &d->transfers[line])
+    sdoStagingOwner = NULL;
+#endif
   if (errorCode != OD_SUCCESSFUL)
     return errorCode;
   MSG_WAR(0x3A08, "exit of SDOlineToObjdict ", line);
@@ -219,6 +340,16 @@ UNS32 objdictToSDOline (CO_Data* d, UNS8 line)
   MSG_WAR(0x3A05, "objdict->line index : ", d->transfers[line].index);
   MSG_WAR(0x3A06, "  subIndex : ", d->transfers[line].subIndex);
 
+  /* The segments are read from the object itself */
+  errorCode = referenceODentry(d, line, 0);
+  if (errorCode != OD_SUCCESSFUL)
+    return errorCode;
+  if (d->transfers[line].pObject) {
+    d->transfers[line].count = d->transfers[line].objectSize;
+    d->transfers[line].offset = 0;
+    return 0;
+  }
+
   errorCode = getODentry(d, 	d->transfers[line].index,
   				d->transfers[line].subIndex,
   				(void *)d->transfers[line].data,
@@ -319,8 +450,9 @@ UNS32 objdictToSDOBlockline(CO_Data* d, UNS8 line, UNS8 numberOfIndexes)
 UNS8 lineToSDO (CO_Data* d, UNS8 line, UNS32 nbBytes, UNS8* data) {
   UNS8 i;
   UNS32 offset;
+  UNS8 *src = lineData(d, line);
 
-  if ((d->transfers[line].offset + nbBytes) > SDO_MAX_LENGTH_TRANSFER) 
+  if ((d->transfers[line].offset + nbBytes) > lineCapacity(d, line)) 
   {
     MSG_ERR(0x1A10,"SDO Size of data too large. Exceed SDO_MAX_LENGTH_TRANSFERT", nbBytes);
     return 0xFF;
@@ -331,7 +463,7 @@ UNS8 lineToSDO (CO_Data* d, UNS8 line, UNS32 nbBytes, UNS8* data) {
   }
   offset = d->transfers[line].offset;
   for (i = 0 ; i < nbBytes ; i++)
-    * (data + i) = d->transfers[line].data[offset + i];
+    * (data + i) = src[offset + i];
   d->transfers[line].offset = d->transfers[line].offset + nbBytes;
   return 0;
 }
@@ -350,14 +482,15 @@ UNS8 SDOtoLine (CO_Data* d, UNS8 line, UNS32 nbBytes, UNS8* data)
 {
   UNS8 i;
   UNS32 offset;
+  UNS8 *dest = lineData(d, line);
 
-  if ((d->transfers[line].offset + nbBytes) > SDO_MAX_LENGTH_TRANSFER) {
+  if ((d->transfers[line].offset + nbBytes) > lineCapacity(d, line)) {
     MSG_ERR(0x1A15,"SDO Size of data too large. Exceed SDO_MAX_LENGTH_TRANSFERT", nbBytes);
     return 0xFF;
   }
   offset = d->transfers[line].offset;
   for (i = 0 ; i < nbBytes ; i++)
-    d->transfers[line].data[offset + i] = * (data + i);
+    dest[offset + i] = * (data + i);
   d->transfers[line].offset = d->transfers[line].offset + nbBytes;
   return 0;
 }
@@ -431,7 +564,8 @@ void resetSDOline ( CO_Data* d, UNS8 line )
 UNS8 initSDOline (CO_Data* d, UNS8 line, UNS8 nodeId, UNS16 index, UNS8 subIndex, UNS8 state)
 {
   MSG_WAR(0x3A25, "init SDO line nb : ", line);
-  if (state == SDO_DOWNLOAD_IN_PROGRESS || state == SDO_UPLOAD_IN_PROGRESS)
+  if (state == SDO_DOWNLOAD_IN_PROGRESS || state == SDO_UPLOAD_IN_PROGRESS ||
+      state == SDO_BLOCK_DOWNLOAD_IN_PROGRESS || state == SDO_BLOCK_UPLOAD_IN_PROGRESS)
   {
   	StartSDO_TIMER(line)
   }else
@@ -447,6 +581,18 @@ UNS8 initSDOline (CO_Data* d, UNS8 line, UNS8 nodeId, UNS16 index, UNS8 subIndex
   d->transfers[line].offset = 0;
   d->transfers[line].dataType = 0;
   d->transfers[line].Callback = NULL;
+  d->transfers[line].blockPhase = SDO_BLOCK_INIT;
+  d->transfers[line].blockSize = 0;
+  d->transfers[line].blockSeq = 0;
+  d->transfers[line].blockLast = 0;
+  d->transfers[line].blockCrc = 0;
+  d->transfers[line].blockStart = 0;
+#if SDO_STAGING_SIZE > 0
+  if (sdoStagingOwner == &d->transfers[line])
+    sdoStagingOwner = NULL;
+#endif
+  d->transfers[line].pObject = NULL;
+  d->transfers[line].objectSize = 0;
   return 0;
 }
 
@@ -557,7 +703,7 @@ UNS8 getSDOlineRestBytes (CO_Data* d, UNS8 line, UNS32 * nbBytes)
 **/
 UNS8 setSDOlineRestBytes (CO_Data* d, UNS8 line, UNS32 nbBytes)
 {
-  if (nbBytes > SDO_MAX_LENGTH_TRANSFER) {
+  if (nbBytes > lineCapacity(d, line)) {
     MSG_ERR(0x1A35,"SDO Size of data too large. Exceed SDO_MAX_LENGTH_TRANSFERT", nbBytes);
     return 0xFF;
   }
@@ -691,6 +837,467 @@ UNS8 sendSDOabort (CO_Data* d, UNS8 whoami, UNS8 nodeID, UNS16 index, UNS8 subIn
   return ret;
 }
 
+/***************************************************************************/
+/* SDO block transfer (CiA 301).
+   An upload reads the line buffer, or the OD object the server line references;
+   a download is collected in the line buffer, or in sdoStaging for an object larger
+   than data[], and written to the dictionary when complete and its CRC checked.
+   A block transfer has the same size limit as the segmented one; the receiver
+   asks for sub-blocks that fit in the room left.
+   Compatibility: cs = 5 with the cc bit clear (0xA0) is the multiple subindex read
+   of readBlockNetworkDict, so the server only takes cs = 5 as a block upload
+   initiate when the client announces CRC support (0xA4). */
+
+/*!
+** CRC of a block transfer: CRC-16-CCITT (x^16 + x^12 + x^5 + 1), initial value 0
+**
+** @param data
+** @param len
+**
+** @return
+**/
+static UNS16 blockCRC (const UNS8 *data, UNS32 len)
+{
+  UNS16 crc = 0;
+  UNS8 bit;
+
+  while (len--) {
+    crc ^= (UNS16)(*data++) << 8;
+    for (bit = 0 ; bit < 8 ; bit++)
+      crc = (crc & 0x8000) ? (UNS16)((crc << 1) ^ 0x1021) : (UNS16)(crc << 1);
+  }
+  return crc;
+}
+
+/*!
+** Number of segments (blksize) the line can still receive, 1 to 127
+**
+** @param d
+** @param line
+**
+** @return
+**/
+static UNS8 blockSizeForLine (CO_Data* d, UNS8 line)
+{
+  UNS32 segments = (lineCapacity(d, line) - d->transfers[line].offset + 6) / 7;
+
+  if (segments < 1)
+    return 1;
+  if (segments > 127)
+    return 127;
+  return (UNS8)segments;
+}
+
+/*!
+** Sends the next sub-block, from the current offset of the line, back to back
+**
+** @param d
+** @param line
+** @param whoami
+**
+** @return
+**/
+static UNS8 sendSDOBlock (CO_Data* d, UNS8 line, UNS8 whoami)
+{
+  s_SDO sdo;
+  UNS32 rest;
+  UNS8 nbBytes;
+  UNS8 i;
+  UNS8 err;
+
+  d->transfers[line].blockStart = d->transfers[line].offset;
+  d->transfers[line].blockSeq = 0;
+  d->transfers[line].blockPhase = SDO_BLOCK_DATA;
+  sdo.nodeId = d->transfers[line].nodeId;
+  while (d->transfers[line].blockSeq < d->transfers[line].blockSize) {
+    rest = d->transfers[line].count - d->transfers[line].offset;
+    nbBytes = (rest > 7) ? 7 : (UNS8)rest;
+    d->transfers[line].blockSeq++;
+    sdo.body.data[0] = d->transfers[line].blockSeq;
+    for (i = 1 ; i < 8 ; i++)
+      sdo.body.data[i] = 0;
+    lineToSDO(d, line, nbBytes, sdo.body.data + 1);
+    if (rest <= 7) {
+      /* Last segment of the transfer */
+      sdo.body.data[0] |= 0x80;
+      d->transfers[line].blockLast = nbBytes;
+      d->transfers[line].blockPhase = SDO_BLOCK_LAST;
+    }
+    err = sendSDO(d, whoami, sdo);
+    if (err)
+      return err;
+    if (rest <= 7)
+      break;
+  }
+  MSG_WAR(0x3B00, "SDO. Sub-block sent, segments : ", d->transfers[line].blockSeq);
+  return 0;
+}
+
+/*!
+** Sender side: the receiver acknowledged a sub-block. Sends the next one, or the
+** end frame with the CRC once the last segment is acknowledged.
+**
+** @param d
+** @param nodeId
+** @param line
+** @param whoami
+** @param m
+**
+** @return
+**/
+static UNS8 ackSDOBlock (CO_Data* d, UNS8 nodeId, UNS8 line, UNS8 whoami, Message *m)
+{
+  s_SDO sdo;
+  UNS16 crc = 0;
+  UNS8 i;
+
+  if (d->transfers[line].blockPhase != SDO_BLOCK_DATA && d->transfers[line].blockPhase != SDO_BLOCK_LAST) {
+    failedSDO(d, nodeId, whoami, d->transfers[line].index, d->transfers[line].subIndex, SDOABT_LOCAL_CTRL_ERROR);
+    return 0xFF;
+  }
+  if (m->data[1] > d->transfers[line].blockSeq) {
+    failedSDO(d, nodeId, whoami, d->transfers[line].index, d->transfers[line].subIndex, SDOABT_INVALID_SEQUENCE);
+    return 0xFF;
+  }
+  if (m->data[2] < 1 || m->data[2] > 127) {
+    failedSDO(d, nodeId, whoami, d->transfers[line].index, d->transfers[line].subIndex, SDOABT_INVALID_BLOCK_SIZE);
+    return 0xFF;
+  }
+  if (d->transfers[line].blockPhase == SDO_BLOCK_LAST && m->data[1] == d->transfers[line].blockSeq) {
+    /* Everything received. End request (download) or end response (upload), ccs / scs = 6, cs / ss = 1 */
+    if (d->transfers[line].blockCrc)
+      crc = blockCRC(lineData(d, line), d->transfers[line].count);
+    sdo.nodeId = d->transfers[line].nodeId;
+    sdo.body.data[0] = (UNS8)((6 << 5) | ((7 - d->transfers[line].blockLast) << 2) | 1);
+    sdo.body.data[1] = (UNS8)crc;
+    sdo.body.data[2] = (UNS8)(crc >> 8);
+    for (i = 3 ; i < 8 ; i++)
+      sdo.body.data[i] = 0;
+    d->transfers[line].blockPhase = SDO_BLOCK_END;
+    MSG_WAR(0x3B01, "SDO. Sending block end to node : ", nodeId);
+    return sendSDO(d, whoami, sdo);
+  }
+  /* Go on from the first segment not received */
+  d->transfers[line].offset = d->transfers[line].blockStart + (UNS32)m->data[1] * 7;
+  d->transfers[line].blockSize = m->data[2];
+  return sendSDOBlock(d, line, whoami);
+}
+
+/*!
+** Receiver side: one segment of a sub-block. Segments out of sequence are dropped;
+** the acknowledge of the sub-block tells the sender where to go on from.
+**
+** @param d
+** @param nodeId
+** @param line
+** @param whoami
+** @param m
+**
+** @return
+**/
+static UNS8 receiveSDOBlockSegment (CO_Data* d, UNS8 nodeId, UNS8 line, UNS8 whoami, Message *m)
+{
+  s_SDO sdo;
+  UNS32 room;
+  UNS8 seq = m->data[0] & 0x7F;
+  UNS8 last = m->data[0] & 0x80;
+  UNS8 nbBytes;
+  UNS8 i;
+
+  if (seq == d->transfers[line].blockSeq + 1) {
+    room = lineCapacity(d, line) - d->transfers[line].offset;
+    if (room < 7 && !last) {
+      failedSDO(d, nodeId, whoami, d->transfers[line].index, d->transfers[line].subIndex, SDOABT_OUT_OF_MEMORY);
+      return 0xFF;
+    }
+    /* The bytes of the last segment that are not data are only known from the end frame */
+    nbBytes = (room < 7) ? (UNS8)room : 7;
+    SDOtoLine(d, line, nbBytes, m->data + 1);
+    d->transfers[line].blockSeq = seq;
+    if (last) {
+      d->transfers[line].blockLast = nbBytes;
+      d->transfers[line].blockPhase = SDO_BLOCK_END;
+    }
+  }
+  if (seq < d->transfers[line].blockSize && !last)
+    return 0;
+
+  /* End of the sub-block: acknowledge, ccs / scs = 5, cs / ss = 2 */
+  d->transfers[line].blockSize = blockSizeForLine(d, line);
+  sdo.nodeId = d->transfers[line].nodeId;
+  sdo.body.data[0] = (5 << 5) | 2;
+  sdo.body.data[1] = d->transfers[line].blockSeq;
+  sdo.body.data[2] = d->transfers[line].blockSize;
+  for (i = 3 ; i < 8 ; i++)
+    sdo.body.data[i] = 0;
+  if (d->transfers[line].blockPhase != SDO_BLOCK_END)
+    d->transfers[line].blockSeq = 0;
+  MSG_WAR(0x3B02, "SDO. Sub-block acknowledged to node : ", nodeId);
+  return sendSDO(d, whoami, sdo);
+}
+
+/*!
+** Receiver side: end request (download) or end response (upload). Checks the size
+** and the CRC, then completes the transfer.
+**
+** @param d
+** @param nodeId
+** @param line
+** @param whoami
+** @param m
+**
+** @return
+**/
+static UNS8 endSDOBlock (CO_Data* d, UNS8 nodeId, UNS8 line, UNS8 whoami, Message *m)
+{
+  s_SDO sdo;
+  UNS16 index = d->transfers[line].index;
+  UNS8 subIndex = d->transfers[line].subIndex;
+  UNS8 lastBytes = 7 - ((m->data[0] >> 2) & 7);
+  UNS32 errorCode;
+  UNS16 crc;
+  UNS8 i;
+
+  if (lastBytes > d->transfers[line].blockLast) {
+    failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_OUT_OF_MEMORY);
+    return 0xFF;
+  }
+  d->transfers[line].offset = d->transfers[line].offset - d->transfers[line].blockLast + lastBytes;
+  d->transfers[line].count = d->transfers[line].offset;
+  if (d->transfers[line].blockCrc) {
+    crc = (UNS16)m->data[1] | ((UNS16)m->data[2] << 8);
+    if (crc != blockCRC(lineData(d, line), d->transfers[line].count)) {
+      MSG_ERR(0x1B00, "SDO error : Block transfer CRC error from node : ", nodeId);
+      failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_CRC_ERROR);
+      return 0xFF;
+    }
+  }
+  if (whoami == SDO_SERVER) {
+    errorCode = SDOlineToObjdict(d, line);
+    if (errorCode) {
+      MSG_ERR(0x1B01, "SDO error : Unable to copy the data in the object dictionary", 0);
+      failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+      return 0xFF;
+    }
+  }
+  /* End response (download, scs = 5) or end request (upload, ccs = 5), ss / cs = 1 */
+  sdo.nodeId = d->transfers[line].nodeId;
+  sdo.body.data[0] = (5 << 5) | 1;
+  for (i = 1 ; i < 8 ; i++)
+    sdo.body.data[i] = 0;
+  sendSDO(d, whoami, sdo);
+  if (whoami == SDO_SERVER) {
+    resetSDOline(d, line);
+    MSG_WAR(0x3B03, "SDO. End of block download defined at index 0x1200 + ", nodeId);
+  }
+  else {
+    StopSDO_TIMER(line)
+    d->transfers[line].state = SDO_FINISHED;
+    MSG_WAR(0x3B04, "SDO. End of block upload from node : ", nodeId);
+    if(d->transfers[line].Callback) (*d->transfers[line].Callback)(d,nodeId);
+  }
+  return 0;
+}
+
+/*!
+** Handles the frames of the block transfers, called by processSDO before the
+** other command specifiers.
+**
+** @param d
+** @param nodeId
+** @param whoami
+** @param m
+**
+** @return 0xFE when the frame is not part of a block transfer (processSDO goes on)
+**/
+static UNS8 processSDOBlock (CO_Data* d, UNS8 nodeId, UNS8 whoami, Message *m)
+{
+  UNS8 err;
+  UNS8 line;
+  UNS8 cs = getSDOcs(m->data[0]);
+  UNS8 subCommand = m->data[0] & 3;
+  UNS8 state;
+  UNS8 phase;
+  UNS16 index;
+  UNS8 subIndex;
+  UNS32 nbBytes;
+  UNS32 errorCode;
+  s_SDO sdo;
+  UNS8 i;
+
+  if (m->data[0] == 0x80)
+    return 0xFE; /* Abort */
+
+  err = getSDOlineOnUse(d, nodeId, whoami, &line);
+  if (!err) {
+    state = d->transfers[line].state;
+    phase = d->transfers[line].blockPhase;
+    if (state != SDO_BLOCK_DOWNLOAD_IN_PROGRESS && state != SDO_BLOCK_UPLOAD_IN_PROGRESS)
+      return 0xFE;
+    /* Reset the wathdog */
+    RestartSDO_TIMER(line)
+    index = d->transfers[line].index;
+    subIndex = d->transfers[line].subIndex;
+
+    if (whoami == SDO_SERVER) {
+      if (state == SDO_BLOCK_DOWNLOAD_IN_PROGRESS) {
+        if (phase == SDO_BLOCK_DATA)
+          return receiveSDOBlockSegment(d, nodeId, line, whoami, m);
+        if (phase == SDO_BLOCK_END && cs == BLOCK_DOWNLOAD_REQUEST && getSDOc(m->data[0]) == SDO_BCS_END_DOWNLOAD_REQUEST)
+          return endSDOBlock(d, nodeId, line, whoami, m);
+      }
+      else if (cs == BLOCK_UPLOAD_REQUEST) {
+        if (subCommand == SDO_BCS_START_UPLOAD && phase == SDO_BLOCK_INIT)
+          return sendSDOBlock(d, line, whoami);
+        if (subCommand == SDO_BCS_UPLOAD_RESPONSE)
+          return ackSDOBlock(d, nodeId, line, whoami, m);
+        if (subCommand == SDO_BCS_END_UPLOAD_REQUEST && phase == SDO_BLOCK_END) {
+          resetSDOline(d, line);
+          MSG_WAR(0x3B05, "SDO. End of block upload defined at index 0x1200 + ", nodeId);
+          return 0;
+        }
+      }
+    }
+    else if (state == SDO_BLOCK_UPLOAD_IN_PROGRESS) {
+      if (phase == SDO_BLOCK_DATA)
+        return receiveSDOBlockSegment(d, nodeId, line, whoami, m);
+      if (phase == SDO_BLOCK_INIT && cs == INITIATE_UPLOAD_RESPONSE) {
+        /* The server switched to the segmented upload */
+        d->transfers[line].state = SDO_UPLOAD_IN_PROGRESS;
+        return 0xFE;
+      }
+      if (phase == SDO_BLOCK_INIT && cs == BLOCK_UPLOAD_RESPONSE && getSDOc(m->data[0]) == SDO_BSS_INITIATE_UPLOAD_RESPONSE) {
+        if ((m->data[0] >> 1) & 1) { /* size indicated */
+          nbBytes = m->data[4] + ((UNS32)(m->data[5])<<8) + ((UNS32)(m->data[6])<<16) + ((UNS32)(m->data[7])<<24);
+          err = setSDOlineRestBytes(d, line, nbBytes);
+          if (err) {
+            failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_OUT_OF_MEMORY);
+            return 0xFF;
+          }
+        }
+        d->transfers[line].blockCrc = (m->data[0] >> 2) & 1;
+        d->transfers[line].blockSeq = 0;
+        d->transfers[line].blockPhase = SDO_BLOCK_DATA;
+        /* Start upload, ccs = 5, cs = 3 */
+        sdo.nodeId = nodeId;
+        sdo.body.data[0] = (BLOCK_UPLOAD_REQUEST << 5) | SDO_BCS_START_UPLOAD;
+        for (i = 1 ; i < 8 ; i++)
+          sdo.body.data[i] = 0;
+        return sendSDO(d, whoami, sdo);
+      }
+      if (phase == SDO_BLOCK_END && cs == BLOCK_UPLOAD_RESPONSE && getSDOc(m->data[0]) == SDO_BSS_END_UPLOAD_RESPONSE)
+        return endSDOBlock(d, nodeId, line, whoami, m);
+    }
+    else if (cs == BLOCK_DOWNLOAD_RESPONSE) {
+      if (subCommand == 0 && phase == SDO_BLOCK_INIT) {
+        /* Initiate download response: sc, blksize */
+        if (m->data[4] < 1 || m->data[4] > 127) {
+          failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_INVALID_BLOCK_SIZE);
+          return 0xFF;
+        }
+        d->transfers[line].blockCrc = (m->data[0] >> 2) & 1;
+        d->transfers[line].blockSize = m->data[4];
+        return sendSDOBlock(d, line, whoami);
+      }
+      if (subCommand == 2)
+        return ackSDOBlock(d, nodeId, line, whoami, m);
+      if (subCommand == 1 && phase == SDO_BLOCK_END) {
+        StopSDO_TIMER(line)
+        d->transfers[line].state = SDO_FINISHED;
+        MSG_WAR(0x3B06, "SDO. End of block download to node : ", nodeId);
+        if(d->transfers[line].Callback) (*d->transfers[line].Callback)(d,nodeId);
+        return 0;
+      }
+    }
+    MSG_ERR(0x1B02, "SDO error : Unexpected frame in block transfer with node : ", nodeId);
+    failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_LOCAL_CTRL_ERROR);
+    return 0xFF;
+  }
+
+  if (whoami != SDO_SERVER)
+    return 0xFE;
+  index = getSDOindex(m->data[1],m->data[2]);
+  subIndex = getSDOsubIndex(m->data[3]);
+
+  if (cs == BLOCK_DOWNLOAD_REQUEST) {
+    if (getSDOc(m->data[0]) == SDO_BCS_END_DOWNLOAD_REQUEST) {
+      MSG_ERR(0x1B03, "SDO error : Received block download end for unstarted trans. index 0x1200 + ", nodeId);
+      failedSDO(d, nodeId, whoami, 0, 0, SDOABT_LOCAL_CTRL_ERROR);
+      return 0xFF;
+    }
+    /* Initiate block download: cc, s, size */
+    err = getSDOfreeLine(d, whoami, &line);
+    if (err) {
+      MSG_ERR(0x1B04, "SDO error : No line free, too many SDO in progress. Aborted.", 0);
+      failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_LOCAL_CTRL_ERROR);
+      return 0xFF;
+    }
+    initSDOline(d, line, nodeId, index, subIndex, SDO_BLOCK_DOWNLOAD_IN_PROGRESS);
+    errorCode = prepareSDOdownload(d, line);
+    if (errorCode) {
+      failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+      return 0xFF;
+    }
+    if ((m->data[0] >> 1) & 1) { /* size indicated */
+      nbBytes = m->data[4] + ((UNS32)(m->data[5])<<8) + ((UNS32)(m->data[6])<<16) + ((UNS32)(m->data[7])<<24);
+      err = setSDOlineRestBytes(d, line, nbBytes);
+      if (err) {
+        failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_OUT_OF_MEMORY);
+        return 0xFF;
+      }
+    }
+    d->transfers[line].blockCrc = (m->data[0] >> 2) & 1;
+    d->transfers[line].blockSize = blockSizeForLine(d, line);
+    d->transfers[line].blockPhase = SDO_BLOCK_DATA;
+    /* Initiate download response, scs = 5, sc = 1 (CRC supported) */
+    sdo.nodeId = nodeId;
+    sdo.body.data[0] = (BLOCK_DOWNLOAD_RESPONSE << 5) | (1 << 2);
+    sdo.body.data[1] = index & 0xFF;        /* LSB */
+    sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
+    sdo.body.data[3] = subIndex;
+    sdo.body.data[4] = d->transfers[line].blockSize;
+    for (i = 5 ; i < 8 ; i++)
+      sdo.body.data[i] = 0;
+    MSG_WAR(0x3B07, "SDO. Sending block download initiate response defined at index 0x1200 + ", nodeId);
+    return sendSDO(d, whoami, sdo);
+  }
+
+  if (cs == BLOCK_UPLOAD_REQUEST && (m->data[0] & (1 << 2)) && subCommand == SDO_BCS_INITIATE_UPLOAD_REQUEST) {
+    /* Initiate block upload: cc, blksize, pst (no protocol switch, always block) */
+    if (m->data[4] < 1 || m->data[4] > 127) {
+      failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_INVALID_BLOCK_SIZE);
+      return 0xFF;
+    }
+    err = getSDOfreeLine(d, whoami, &line);
+    if (err) {
+      MSG_ERR(0x1B05, "SDO error : No line free, too many SDO in progress. Aborted.", 0);
+      failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_LOCAL_CTRL_ERROR);
+      return 0xFF;
+    }
+    initSDOline(d, line, nodeId, index, subIndex, SDO_BLOCK_UPLOAD_IN_PROGRESS);
+    errorCode = objdictToSDOline(d, line);
+    if (errorCode) {
+      MSG_ERR(0x1B06, "SDO error : Unable to copy the data from object dictionary. Err code : ", errorCode);
+      failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+      return 0xFF;
+    }
+    d->transfers[line].blockSize = m->data[4];
+    d->transfers[line].blockCrc = 1;
+    /* Initiate upload response, scs = 6, sc = 1, s = 1, size */
+    getSDOlineRestBytes(d, line, &nbBytes);
+    sdo.nodeId = nodeId;
+    sdo.body.data[0] = (BLOCK_UPLOAD_RESPONSE << 5) | (1 << 2) | (1 << 1);
+    sdo.body.data[1] = index & 0xFF;        /* LSB */
+    sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
+    sdo.body.data[3] = subIndex;
+    for (i = 0 ; i < 4 ; i++)
+      sdo.body.data[i+4] = (UNS8)(nbBytes >> (i<<3));
+    MSG_WAR(0x3B08, "SDO. Sending block upload initiate response defined at index 0x1200 + ", nodeId);
+    return sendSDO(d, whoami, sdo);
+  }
+  return 0xFE;
+}
+
 /*!
 **
 **
@@ -791,6 +1398,11 @@ UNS8 processSDO (CO_Data* d, Message *m)
     MSG_WAR(0x3A69, "I am SERVER. Received SDO cobId : ", UNS16_LE(m->cob_id));
   }
 
+  /* Block transfer frames, segments included, are not decoded by the switch below */
+  err = processSDOBlock(d, nodeId, whoami, m);
+  if (err != 0xFE)
+    return err;
+
   /* Testing the command specifier */
   /* Allowed : cs = 0, 1, 2, 3, 4. (=  all except those for block tranfert). */
   /* cs = other : Not allowed -> abort. */
@@ -971,9 +1583,14 @@ UNS8 processSDO (CO_Data* d, Message *m)
       }
       else 
       {/* So, if it is not an expedited transfer */
+	errorCode = prepareSDOdownload(d, line);
+	if (errorCode) {
+	  failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+	  return 0xFF;
+	}
 	if (getSDOs(m->data[0])) {
 	  nbBytes = (m->data[4]) + ((UNS32)(m->data[5])<<8) + ((UNS32)(m->data[6])<<16) + ((UNS32)(m->data[7])<<24);
-	  err = setSDOlineRestBytes(d, nodeId, nbBytes);
+	  err = setSDOlineRestBytes(d, line, nbBytes);
 	  if (err) {
 	    failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_GENERAL_ERROR);
 	    return 0xFF;
@@ -1104,11 +1721,8 @@ UNS8 processSDO (CO_Data* d, Message *m)
 	sdo.body.data[1] = index & 0xFF;        /* LSB */
 	sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
 	sdo.body.data[3] = subIndex;
-        sdo.body.data[4] = (UNS8)nbBytes; /* Limitation of canfestival2 : Max tranfert is 256 bytes.*/
-	/* It takes too much memory to upgrate to 2^32 because the size of data is also coded */
-	/* in the object dictionary, at every index and subindex. */
-	for (i = 5 ; i < 8 ; i++)
-	  sdo.body.data[i] = 0;
+	for (i = 0 ; i < 4 ; i++)
+	  sdo.body.data[i+4] = (UNS8)(nbBytes >> (i<<3));
 	MSG_WAR(0x3A95, "SDO. Sending normal upload initiate response defined at index 0x1200 + ", nodeId);
 	sendSDO(d, whoami, sdo);
       }
@@ -1396,11 +2010,8 @@ UNS8 processSDO (CO_Data* d, Message *m)
 	sdo.body.data[1] = index & 0xFF;        /* LSB */
 	sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
 	sdo.body.data[3] = subIndex;
-        sdo.body.data[4] = (UNS8)nbBytes; /* Limitation of canfestival2 : Max tranfert is 256 bytes.*/
-	/* It takes too much memory to upgrate to 2^32 because the size of data is also coded */
-	/* in the object dictionary, at every index and subindex. */
-	for (i = 5 ; i < 8 ; i++)
-	  sdo.body.data[i] = 0;
+	for (i = 0 ; i < 4 ; i++)
+	  sdo.body.data[i+4] = (UNS8)(nbBytes >> (i<<3));
 	MSG_WAR(0x3A95, "SDO. Sending normal upload initiate response defined at index 0x1200 + ", nodeId);
 	sendSDO(d, whoami, sdo);
       }
@@ -2015,6 +2626,159 @@ UNS8 readNetworkDictCallbackAI (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subIn
 	}
 }
 
+/*!
+** Opens a client line for a block transfer with nodeId
+**
+** @param d
+** @param nodeId
+** @param line
+**
+** @return 0xFE when no SDO client is defined for nodeId
+**/
+static UNS8 getSDOclientBlockLine (CO_Data* d, UNS8 nodeId, UNS8 *line)
+{
+  UNS16 offset;
+  UNS16 lastIndex;
+
+  /* Verify that there is no SDO communication yet. */
+  if (!getSDOlineOnUse(d, nodeId, SDO_CLIENT, line)) {
+    MSG_ERR(0x1B07, "SDO error : Communication yet established. with node : ", nodeId);
+    return 0xFF;
+  }
+  /* Check which SDO to use to communicate with the node */
+  offset = d->firstIndex->SDO_CLT;
+  lastIndex = d->lastIndex->SDO_CLT;
+  if (offset == 0) {
+    MSG_ERR(0x1B08, "SDO block : No SDO client index found", 0);
+    return 0xFF;
+  }
+  while (offset <= lastIndex) {
+    if (d->objdict[offset].bSubCount <= 3)
+      return 0xFF;
+    if (*(UNS8*) d->objdict[offset].pSubindex[3].pObject == nodeId)
+      break;
+    offset++;
+  }
+  if (offset > lastIndex) {
+    MSG_ERR(0x1B09, "SDO. Error. No client found to communicate with node : ", nodeId);
+    return 0xFE;
+  }
+  /* Taking the line ... */
+  if (getSDOfreeLine(d, SDO_CLIENT, line)) {
+    MSG_ERR(0x1B0A, "SDO error : No line free, too many SDO in progress. Aborted for node : ", nodeId);
+    return 0xFF;
+  }
+  return 0;
+}
+
+/*!
+**
+**
+** @param d
+** @param nodeId
+** @param index
+** @param subIndex
+** @param count
+** @param dataType
+** @param data
+** @param Callback
+**
+** @return
+**/
+UNS8 writeNetworkDictBlockCallback (CO_Data* d, UNS8 nodeId, UNS16 index,
+		       UNS8 subIndex, UNS32 count, UNS8 dataType, void *data, SDOCallback_t Callback)
+{
+  UNS8 err;
+  UNS8 line;
+  s_SDO sdo;
+  UNS32 j;
+
+  MSG_WAR(0x3B09, "Send SDO block download to node : ", nodeId);
+  if (count > SDO_MAX_LENGTH_TRANSFER)
+    return 0xFF;
+  err = getSDOclientBlockLine(d, nodeId, &line);
+  if (err)
+    return err;
+  initSDOline(d, line, nodeId, index, subIndex, SDO_BLOCK_DOWNLOAD_IN_PROGRESS);
+  d->transfers[line].count = count;
+  d->transfers[line].dataType = dataType;
+  for (j = 0 ; j < count ; j++) {
+# ifdef CANOPEN_BIG_ENDIAN
+    if (dataType == 0)
+      d->transfers[line].data[count - 1 - j] = ((char *)data)[j];
+    else /* String of bytes. */
+      d->transfers[line].data[j] = ((char *)data)[j];
+#  else
+    d->transfers[line].data[j] = ((char *)data)[j];
+#  endif
+  }
+  d->transfers[line].Callback = Callback;
+
+  /* Initiate block download, ccs = 6, cc = 1 (CRC supported), s = 1, size */
+  sdo.nodeId = nodeId;
+  sdo.body.data[0] = (BLOCK_DOWNLOAD_REQUEST << 5) | (1 << 2) | (1 << 1);
+  sdo.body.data[1] = index & 0xFF;        /* LSB */
+  sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
+  sdo.body.data[3] = subIndex;
+  for (j = 0 ; j < 4 ; j++)
+    sdo.body.data[j+4] = (UNS8)(count >> (j<<3));
+  err = sendSDO(d, SDO_CLIENT, sdo);
+  if (err) {
+    MSG_ERR(0x1B0B, "SDO. Error while sending SDO to node : ", nodeId);
+    /* release the line */
+    resetSDOline(d, line);
+    return 0xFF;
+  }
+  return 0;
+}
+
+/*!
+**
+**
+** @param d
+** @param nodeId
+** @param index
+** @param subIndex
+** @param dataType
+** @param Callback
+**
+** @return
+**/
+UNS8 readNetworkDictBlockCallback (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subIndex, UNS8 dataType, SDOCallback_t Callback)
+{
+  UNS8 err;
+  UNS8 line;
+  s_SDO sdo;
+  UNS8 i;
+
+  MSG_WAR(0x3B0A, "Send SDO block upload to node : ", nodeId);
+  err = getSDOclientBlockLine(d, nodeId, &line);
+  if (err)
+    return err;
+  initSDOline(d, line, nodeId, index, subIndex, SDO_BLOCK_UPLOAD_IN_PROGRESS);
+  d->transfers[line].dataType = dataType;
+  d->transfers[line].blockSize = blockSizeForLine(d, line);
+  d->transfers[line].Callback = Callback;
+
+  /* Initiate block upload, ccs = 5, cc = 1 (CRC supported), blksize, pst = 0 (no protocol switch) */
+  sdo.nodeId = nodeId;
+  sdo.body.data[0] = (BLOCK_UPLOAD_REQUEST << 5) | (1 << 2) | SDO_BCS_INITIATE_UPLOAD_REQUEST;
+  sdo.body.data[1] = index & 0xFF;        /* LSB */
+  sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
+  sdo.body.data[3] = subIndex;
+  sdo.body.data[4] = d->transfers[line].blockSize;
+  for (i = 5 ; i < 8 ; i++)
+    sdo.body.data[i] = 0;
+  err = sendSDO(d, SDO_CLIENT, sdo);
+  if (err) {
+    MSG_ERR(0x1B0C, "SDO. Error while sending SDO to node : ", nodeId);
+    /* release the line */
+    resetSDOline(d, line);
+    return 0xFF;
+  }
+  return 0;
+}
+
 /*!
 **
 **
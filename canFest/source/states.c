@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "sysdep.h"
 #include "includes.h"
 #include "RMBootloader.h"
+#include "can_cpu.h"
 
 /** Prototypes for internals functions */
 /*!                                                                                                
@@ -124,8 +125,11 @@ void canDispatch(CO_Data* d, Message *m)
 		case SDOrx:                     
 			if (d->CurrentCommunicationState.csSDO)
                         {
-				processSDO(d,m);
-                                processCANGateway();
+                                LockSDOLines();
+                                if (!completeCANGatewayFastSDO(cob_id, m->data)) //expedited gateway reply
+                                  processSDO(d,m);
+                                UnlockSDOLines();
+                                processCANGateway( (UNS8)(cob_id & 0x7F) );
                         }
                                 
 			break;
@@ -417,6 +421,8 @@ void setNodeId(CO_Data* d, UNS8 nodeId)
 
   /* bDeviceNodeId is defined in the object dictionary. */
   *d->bDeviceNodeId = nodeId;
+  
+  canUpdateFilter();  /* SDO server COB-ID may have changed */
 }
 
 void _mode_X_Manual(CO_Data* d){}
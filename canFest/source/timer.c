@@ -32,16 +32,99 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 /* #define DEBUG_WAR_CONSOLE_ON */
 /* #define DEBUG_ERR_CONSOLE_ON */
 
+#include <includes.h>
 #include <applicfg.h>
 #include "timer.h"
 
 /*  ---------  The timer table --------- */
+/* Armed timers are kept in a binary min-heap ordered by their absolute expiry time (getCurrentTime() units, 
+ * compared modulo 2^32), so arming, cancelling and expiring a timer is O(log n) and TimeDispatch only touches
+ * the timers that are due. A row keeps its handle while it is armed; free rows are kept on a stack. */
 s_timer_entry timers[MAX_NB_TIMER] = {{TIMER_FREE, NULL, NULL, 0, 0, 0},};
 
-TIMEVAL total_sleep_time = TIMEVAL_MAX;
-TIMER_HANDLE last_timer_raw = -1;
+static UNS8 timer_heap[MAX_NB_TIMER];		/* handles, soonest first */
+static UNS8 timer_heap_pos[MAX_NB_TIMER];	/* position of an armed handle in timer_heap */
+static UNS8 timer_heap_count = 0;
+static UNS8 free_rows[MAX_NB_TIMER];		/* released handles */
+static UNS8 free_row_count = 0;
+static UNS8 unused_rows = 0;				/* rows from here on were never used */
 
-#define min_val(a,b) ((a<b)?a:b)
+#define TIMER_MIN_DELAY		2		/* a timer due this soon is dispatched now rather than set */
+#define TIMER_BEFORE(a,b)	((INTEGER32)(timers[a].val - timers[b].val) < 0)
+
+/*!
+** Moves a heap entry towards the top while it expires before its parent
+**
+** @param pos
+**/
+static void heapUp(UNS8 pos)
+{
+	UNS8 handle = timer_heap[pos];
+
+	while (pos > 0 && TIMER_BEFORE(handle, timer_heap[(pos - 1) >> 1]))
+	{
+		timer_heap[pos] = timer_heap[(pos - 1) >> 1];
+		timer_heap_pos[timer_heap[pos]] = pos;
+		pos = (pos - 1) >> 1;
+	}
+	timer_heap[pos] = handle;
+	timer_heap_pos[handle] = pos;
+}
+
+/*!
+** Moves a heap entry towards the bottom while a child expires before it
+**
+** @param pos
+**/
+static void heapDown(UNS8 pos)
+{
+	UNS8 handle = timer_heap[pos];
+	UNS8 child;
+
+	while ((child = (pos << 1) + 1) < timer_heap_count)
+	{
+		if (child + 1 < timer_heap_count && TIMER_BEFORE(timer_heap[child + 1], timer_heap[child]))
+			child++;
+		if (!TIMER_BEFORE(timer_heap[child], handle))
+			break;
+		timer_heap[pos] = timer_heap[child];
+		timer_heap_pos[timer_heap[pos]] = pos;
+		pos = child;
+	}
+	timer_heap[pos] = handle;
+	timer_heap_pos[handle] = pos;
+}
+
+/*!
+** Adds an armed row to the heap
+**
+** @param handle
+**/
+static void heapInsert(UNS8 handle)
+{
+	timer_heap[timer_heap_count] = handle;
+	heapUp(timer_heap_count++);
+}
+
+/*!
+** Removes a row from the heap
+**
+** @param handle
+**/
+static void heapRemove(UNS8 handle)
+{
+	UNS8 pos = timer_heap_pos[handle];
+	UNS8 moved;
+
+	if (pos != --timer_heap_count)
+	{
+		/* the last entry fills the hole and moves whichever way it belongs */
+		moved = timer_heap[timer_heap_count];
+		timer_heap[pos] = moved;
+		heapDown(pos);
+		heapUp(timer_heap_pos[moved]);
+	}
+}
 
 /*!
 ** -------  Use this to declare a new alarm ------
@@ -56,43 +139,39 @@ TIMER_HANDLE last_timer_raw = -1;
 **/
 TIMER_HANDLE SetAlarm(CO_Data* d, UNS32 id, TimerCallback_t callback, TIMEVAL value, TIMEVAL period)
 {
-	TIMER_HANDLE row_number;
+	UNS8 row_number;
 	s_timer_entry *row;
-        
-      
-        
-	/* in order to decide new timer setting we have to run over all timer rows */
-	for(row_number=0, row=timers; row_number <= last_timer_raw + 1 && row_number < MAX_NB_TIMER; row_number++, row++)
+	CPU_SR_ALLOC();
+
+	if (!callback)
+		return TIMER_NONE;
+
+	CPU_CRITICAL_ENTER();
+	if (free_row_count)
+		row_number = free_rows[--free_row_count];
+	else if (unused_rows < MAX_NB_TIMER)
+		row_number = unused_rows++;
+	else
 	{
-		if (callback && 	/* if something to store */
-		   row->state == TIMER_FREE) /* and empty row */
-		{	/* just store */
-			TIMEVAL real_timer_value;
-			TIMEVAL elapsed_time;
-
-			if (row_number == last_timer_raw + 1) last_timer_raw++;
-
-			elapsed_time = getElapsedTime();
-			/* set next wakeup alarm if new entry is sooner than others, or if it is alone */
-			real_timer_value = value;
-			//^^real_timer_value = min_val(real_timer_value, TIMEVAL_MAX);
-
-			if (total_sleep_time > elapsed_time && total_sleep_time - elapsed_time > real_timer_value)
-			{
-				total_sleep_time = elapsed_time + real_timer_value;
-				setTimer(real_timer_value);
-			}
-			row->callback = callback;
-			row->d = d;
-			row->id = id;
-			row->val = value + elapsed_time;
-			row->interval = period;
-			row->state = TIMER_ARMED;
-			return row_number;
-		}
+		CPU_CRITICAL_EXIT();
+		return TIMER_NONE;
 	}
 
-	return TIMER_NONE;
+	row = &timers[row_number];
+	row->callback = callback;
+	row->d = d;
+	row->id = id;
+	row->val = getCurrentTime() + value;
+	row->interval = period;
+	row->state = TIMER_ARMED;
+	heapInsert(row_number);
+
+	/* set next wakeup alarm if new entry is the soonest */
+	if (timer_heap[0] == row_number)
+		setTimer(value);
+	CPU_CRITICAL_EXIT();
+
+	return row_number;
 }
 
 /*!
@@ -104,13 +183,21 @@ TIMER_HANDLE SetAlarm(CO_Data* d, UNS32 id, TimerCallback_t callback, TIMEVAL va
 **/
 TIMER_HANDLE DelAlarm(TIMER_HANDLE handle)
 {
-	/* Quick and dirty. system timer will continue to be trigged, but no action will be preformed. */
+	/* The system timer is not changed, if it was set for this alarm TimeDispatch finds nothing to do. */
+	CPU_SR_ALLOC();
+
 	MSG_WAR(0x3320, "DelAlarm. handle = ", handle);
-	if(handle != TIMER_NONE)
+	if(handle >= 0 && handle < MAX_NB_TIMER)
 	{
-		if(handle == last_timer_raw)
-			last_timer_raw--;
-		timers[handle].state = TIMER_FREE;
+		CPU_CRITICAL_ENTER();
+		if (timers[handle].state != TIMER_FREE)
+		{
+			if (timers[handle].state & TIMER_ARMED)
+				heapRemove((UNS8) handle);
+			timers[handle].state = TIMER_FREE;	/* also cancels a trig pending in TimeDispatch */
+			free_rows[free_row_count++] = (UNS8) handle;
+		}
+		CPU_CRITICAL_EXIT();
 	}
 	return TIMER_NONE;
 }
@@ -119,65 +206,70 @@ TIMER_HANDLE DelAlarm(TIMER_HANDLE handle)
 ** ------  TimeDispatch is called on each timer expiration ----
 **
 **/
-int tdcount=0;
 void TimeDispatch(void)
 {
-	TIMER_HANDLE i;
-	TIMEVAL next_wakeup = TIMEVAL_MAX; /* used to compute when should normaly occur next wakeup */
-	/* First run : change timer state depending on time */
-	/* Get time since timer signal */
-	TIMEVAL overrun = getElapsedTime();
-
-	TIMEVAL real_total_sleep_time = total_sleep_time + overrun;
-
+	UNS8 due[MAX_NB_TIMER];
+	UNS8 due_count = 0;
+	UNS8 i;
+	TIMEVAL now;
 	s_timer_entry *row;
+	TimerCallback_t callback;
+	CO_Data* d;
+	UNS32 id;
+	CPU_SR_ALLOC();
 
-	for(i=0, row = timers; i <= last_timer_raw; i++, row++)
+	/* First run : take the due timers off the heap, periodic ones go back with their next expiry */
+	CPU_CRITICAL_ENTER();
+	while (timer_heap_count)
 	{
-		if (row->state & TIMER_ARMED) /* if row is active */
+		row = &timers[timer_heap[0]];
+		now = getCurrentTime();
+		if ((INTEGER32)(row->val - now) > TIMER_MIN_DELAY)
+		{
+			/* Set timer to soonest occurence */
+			setTimer(row->val - now);
+			break;
+		}
+		if (due_count == MAX_NB_TIMER)	/* a periodic timer came due again: finish this run first */
 		{
-			if (row->val <= real_total_sleep_time) /* to be trigged */
-			{
-				if (!row->interval) /* if simply outdated */
-				{
-					row->state = TIMER_TRIG; /* ask for trig */
-				}
-				else /* or period have expired */
-				{
-					/* set val as interval, with overrun correction */
-					row->val = row->interval - (overrun % row->interval);
-					row->state = TIMER_TRIG_PERIOD; /* ask for trig, periodic */
-					/* Check if this new timer value is the soonest */
-					if(row->val < next_wakeup)
-						next_wakeup = row->val;
-				}
-			}
-			else
-			{
-				/* Each armed timer value in decremented. */
-				row->val -= real_total_sleep_time;
-
-				/* Check if this new timer value is the soonest */
-				if(row->val < next_wakeup)
-					next_wakeup = row->val;
-			}
+			setTimer(TIMER_MIN_DELAY);
+			break;
+		}
+		due[due_count++] = timer_heap[0];
+		heapRemove(timer_heap[0]);
+		if (!row->interval) /* if simply outdated */
+		{
+			row->state = TIMER_TRIG; /* ask for trig */
+		}
+		else /* or period have expired */
+		{
+			row->val += row->interval;
+			if ((INTEGER32)(row->val - now) <= 0)	/* overrun: skip the missed periods */
+				row->val = now + row->interval - ((now - row->val) % row->interval);
+			/* a next expiry just ahead of now is kept, the loop finds it due again */
+			row->state = TIMER_TRIG_PERIOD; /* ask for trig, periodic */
+			heapInsert(due[due_count - 1]);
 		}
 	}
-
-	/* Remember how much time we should sleep. */
-	total_sleep_time = next_wakeup;
-
-	/* Set timer to soonest occurence */
-	setTimer(next_wakeup);
+	CPU_CRITICAL_EXIT();
 
 	/* Then trig them or not. */
-	for(i=0, row = timers; i<=last_timer_raw; i++, row++)
+	for (i = 0; i < due_count; i++)
 	{
+		row = &timers[due[i]];
+		callback = NULL;
+		CPU_CRITICAL_ENTER();
 		if (row->state & TIMER_TRIG)
 		{
 			row->state &= ~TIMER_TRIG; /* reset trig state (will be free if not periodic) */
-			if(row->callback)
-				(*row->callback)(row->d, row->id); /* trig ! */
+			if (row->state == TIMER_FREE)
+				free_rows[free_row_count++] = due[i];
+			callback = row->callback;
+			d = row->d;
+			id = row->id;
 		}
+		CPU_CRITICAL_EXIT();
+		if (callback)
+			(*callback)(d, id); /* trig ! */
 	}
 }
@@ -31,27 +31,159 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "can_cpu.h"
 #include "canfestival.h"
 #include "drv_can_reg.h"
+#include "drv_can.h"
 #include "includes.h"
 #include "sys.h"
+#include "RunCANServer.h"
 
 
 
 volatile unsigned char msg_received = 0;
 extern const CANBUS_PARA CanCfg;
 
+/* Receive ring, bus 0.  The RX ISR (canReceiveISR) is the only writer of canRxWr and fills the
+   slots straight from the CAN registers; RunCANServerTask is the only reader of the slots and the 
+   only writer of canRxRd, and dispatches the frames in place.  Both indexes run freely (UNS8 wrap),
+   the slot is index & (CAN_RX_RING_SIZE - 1), and the ring is full when canRxWr - canRxRd == 
+   CAN_RX_RING_SIZE.  No lock is needed: a slot is only released (canRxRd++) after it was dispatched,
+   and the ISR only writes a slot after reading canRxRd */
+static Message canRxRing[CAN_RX_RING_SIZE];
+static volatile UNS8 canRxWr = 0;
+static volatile UNS8 canRxRd = 0;
+
+/* Transmit queue, bus 0.  canSend inserts the frame into canTxQueue, which is ordered by COB-ID (lowest 
+   first, in order of arrival among equal COB-IDs), and canTxLoad moves the first frames into the three TX 
+   buffers of the controller.  The TX ISR (canTransmitISR) releases the buffers that were sent and loads the 
+   next frames.  The controller stays in CAN ID priority mode (C1MOD.TPM = 0, TFI PRIO unused), so the lowest 
+   COB-ID of the loaded buffers is sent first.  A frame is not loaded while a frame with the same COB-ID is 
+   still in a buffer, so SDO segments and other same COB-ID frames leave in order, and SDO and error control 
+   frames use at most two buffers: one is always left for NMT, SYNC, EMCY and PDOs */
+#define CAN_TX_BUFFERS          3
+#define CAN_TX_FREE             0xFFFF  //canTxBufId of a released TX buffer
+#define CAN_TX_CLASS_SDO        2       //first traffic class limited to CAN_TX_BUFFERS - 1 buffers
+
+typedef struct
+{
+  Message m;
+  UNS32 queued;         //Timer1 count (8 us) when canSend queued it
+} CAN_TX_ENTRY;
+
+static CAN_TX_ENTRY canTxQueue[CAN_TX_QUEUE_SIZE];
+static UNS8 canTxCount = 0;
+static UNS16 canTxBufId[CAN_TX_BUFFERS] = { CAN_TX_FREE, CAN_TX_FREE, CAN_TX_FREE };
+static UNS32 canTxBufQueued[CAN_TX_BUFFERS];
+
+/* Hardware acceptance filter, bus 0.  Only the standard COB-IDs the PM consumes reach the RX ISR: the
+   ranges below, which are accepted from any node, and the single COB-IDs taken from the object dictionary
+   by canUpdateFilter (NMT, SYNC 0x1005, SDO server 0x1200, RPDOs 0x1400.., and the TPDOs 0x1800.. sent on 
+   request, so their remote frames reach processPDO).  Extended frames are dropped */
+#define CAN_AFMR_ACC_BP         0x02    //acceptance filter bypassed, all frames received
+#define CAN_FILTER_DISABLED     0x1000  //LUT entry never matches, pads the single ID table to full words
+#define CAN_FILTER_MAX_IDS      24
+
+static const UNS16 canFilterRange[][2] = 
+{
+  { 0x081, 0x0FF },     //EMCY
+  { 0x100, 0x17F },     //RM bootloader replies, see ProcessRMBOOT
+  { 0x490, 0x49F },     //high speed PDO stream, see processHSPDO
+  { 0x581, 0x5FF },     //SDO responses to the client lines and the CAN gateway
+  { 0x701, 0x77F }      //heartbeat and boot-up, kept for all nodes by the NMT master (covers 0x1016)
+};
+#define CAN_FILTER_RANGES       (sizeof(canFilterRange) / sizeof(canFilterRange[0]))
+
+static void canTxFlush(void);
+
 void canEnable(void)
 {
-  CPU_INT16U timeout_ticks;
-  
   PCONP |= BIT13;  //enable CAN1 peripheral
   CanBusEnable((CANBUS_PARA *) &CanCfg); 
   
-    //Network must be enabled before timeouts are set
-  //JML >> timeout units are in ticks (1tick = 1ms)
-  timeout_ticks = 10;  //maximum waiting time to transmit if transmitter is busy
-  //this will block the task calling canSend, and should not be left infinte (0)
-  CanBusIoCtl(0, CANBUS_SET_TX_TIMEOUT, &timeout_ticks); 
-  //The RX timeout can stay the default of 0 (infinite), because the canReceive 
+  //bus 0 frames bypass the uC-CAN queues (see canSend and canReceiveISR), no uC-CAN timeouts to set
+  canTxFlush();  //frames left in the TX buffers when CAN was disabled
+  canUpdateFilter();
+}
+
+static UNS8 canFilterAdd(UNS16 *ids, UNS8 n, UNS32 cobId)
+/******************************************************************************
+Inserts a COB-ID into the sorted single ID table unless it is invalid, already
+there or accepted by one of the ranges
+OUTPUT	new number of IDs
+******************************************************************************/
+{
+  UNS8 i, j;
+  
+  if( cobId > 0x7FF || n >= CAN_FILTER_MAX_IDS )
+    return n;
+  for( i = 0; i < CAN_FILTER_RANGES; i++ )
+    if( cobId >= canFilterRange[i][0] && cobId <= canFilterRange[i][1] )
+      return n;
+  for( i = 0; i < n && ids[i] < cobId; i++ )
+    ;
+  if( i < n && ids[i] == cobId )
+    return n;
+  for( j = n; j > i; j-- )
+    ids[j] = ids[j - 1];
+  ids[i] = (UNS16)cobId;
+  return n + 1;
+}
+
+void canUpdateFilter(void)
+/******************************************************************************
+Programs the acceptance filter from the object dictionary.  Called by canEnable
+and whenever an entry it depends on is written (ODentryWritten, setNodeId).  While 
+CAN is off the filter is left alone, canEnable programs it when CAN is powered.
+The filter is bypassed while the tables are rewritten, so no frame is lost.
+******************************************************************************/
+{
+  CO_Data *d = &ObjDict_Data;
+  UNS16 ids[CAN_FILTER_MAX_IDS + 1];
+  UNS16 offset, lastIndex;
+  volatile CPU_INT32U *lut;
+  UNS8 n = 0, i, transmissionType;
+  CPU_SR_ALLOC();
+  
+  if (!(PCONP & BIT13))  // check that CAN peripheral is active
+    return;
+  
+  n = canFilterAdd(ids, n, NMT);
+  n = canFilterAdd(ids, n, *d->COB_ID_Sync & 0x7FF);
+#ifdef CO_ENABLE_LSS
+  n = canFilterAdd(ids, n, SLSS_ADRESS);
+#endif
+  offset = d->firstIndex->SDO_SVR;
+  if( offset )
+    n = canFilterAdd(ids, n, *(UNS32 *)d->objdict[offset].pSubindex[1].pObject);
+  offset = d->firstIndex->PDO_RCV;
+  lastIndex = d->lastIndex->PDO_RCV;
+  if( offset ) 
+    for( ; offset <= lastIndex; offset++ )
+      n = canFilterAdd(ids, n, *(UNS32 *)d->objdict[offset].pSubindex[1].pObject);
+  offset = d->firstIndex->PDO_TRS;
+  lastIndex = d->lastIndex->PDO_TRS;
+  if( offset ) 
+    for( ; offset <= lastIndex; offset++ )
+    {
+      transmissionType = *(UNS8 *)d->objdict[offset].pSubindex[2].pObject;
+      if( transmissionType == TRANS_RTR || transmissionType == TRANS_RTR_SYNC )
+        n = canFilterAdd(ids, n, *(UNS32 *)d->objdict[offset].pSubindex[1].pObject);
+    }
+  if( n & 1 )
+    ids[n++] = CAN_FILTER_DISABLED | 0x7FF;  //sorts after every valid ID
+  
+  CPU_CRITICAL_ENTER();
+  LPC21XX_CAN_AFMR = CAN_AFMR_ACC_BP;
+  lut = LPC21XX_CAN_ACCEPTANCE_FILTER;
+  for( i = 0; i < n; i += 2 )  //two IDs per word, lower ID in the upper half, controller 0 (CAN1)
+    *lut++ = ((CPU_INT32U)ids[i] << 16) | ids[i + 1];
+  for( i = 0; i < CAN_FILTER_RANGES; i++ )
+    *lut++ = ((CPU_INT32U)canFilterRange[i][0] << 16) | canFilterRange[i][1];
+  LPC21XX_CAN_SFF_SA = 0;
+  LPC21XX_CAN_SFF_GRP_SA = (CPU_INT32U)n * 2;
+  LPC21XX_CAN_EFF_SA = LPC21XX_CAN_SFF_GRP_SA + CAN_FILTER_RANGES * 4;
+  LPC21XX_CAN_EFF_GRP_SA = LPC21XX_CAN_EFF_SA;
+  LPC21XX_CAN_END_OF_TABLE = LPC21XX_CAN_EFF_SA;
+  LPC21XX_CAN_AFMR = 0;  //filter on
+  CPU_CRITICAL_EXIT();
 }
 
 void canDisable( void )
@@ -78,79 +210,260 @@ void canReset( void )
   CanBusIoCtl(0, CANBUS_FLUSH_TX, NULL); // reset the can bus
   CanBusIoCtl(0, CANBUS_FLUSH_RX, NULL); //
   CanBusIoCtl(0, CANBUS_RESET, NULL); //
+  canTxFlush();  //the reset released the TX buffers
   
   CAN_Rx_ErrCounter = (LPC21XX_CAN_C1GSR >> 16) & 0x00FF; 
   CAN_Tx_ErrCounter = (LPC21XX_CAN_C1GSR >> 24) & 0x00FF;
 }
 
+static UNS8 canTxClass(UNS16 cobId)
+/******************************************************************************
+Traffic class of a COB-ID, for the TX buffer limit and CAN_Transmit_MaxLatency
+******************************************************************************/
+{
+  if( cobId < 0x180 )
+    return 0;   //NMT, SYNC, EMCY, RM bootloader
+  if( cobId < 0x580 )
+    return 1;   //PDO
+  if( cobId < 0x700 )
+    return 2;   //SDO
+  return 3;     //heartbeat, node guarding, LSS
+}
+
+static void canTxFlush(void)
+/******************************************************************************
+Drops the queued frames and marks the TX buffers released, for a controller 
+that was reset or powered down
+******************************************************************************/
+{
+  UNS8 b;
+  CPU_SR_ALLOC();
+  
+  CPU_CRITICAL_ENTER();
+  canTxCount = 0;
+  for( b = 0; b < CAN_TX_BUFFERS; b++ )
+    canTxBufId[b] = CAN_TX_FREE;
+  CPU_CRITICAL_EXIT();
+}
+
+static void canTxLoad(void)
+/******************************************************************************
+Moves queued frames into the free TX buffers, highest priority first.  Called 
+with interrupts disabled.
+******************************************************************************/
+{
+  volatile CPU_INT32U *tx;
+  Message *m;
+  UNS8 i, b, used = 0, usedSDO = 0;
+  
+  for( b = 0; b < CAN_TX_BUFFERS; b++ )
+    if( canTxBufId[b] != CAN_TX_FREE )
+    {
+      used++;
+      if( canTxClass(canTxBufId[b]) >= CAN_TX_CLASS_SDO )
+        usedSDO++;
+    }
+  
+  while( used < CAN_TX_BUFFERS )
+  {
+    /* first queued frame that may be loaded */
+    for( i = 0; i < canTxCount; i++ )
+    {
+      m = &canTxQueue[i].m;
+      if( canTxClass(m->cob_id) >= CAN_TX_CLASS_SDO && usedSDO >= CAN_TX_BUFFERS - 1 )
+        return;  //the rest of the queue is SDO and error control as well
+      for( b = 0; b < CAN_TX_BUFFERS && canTxBufId[b] != m->cob_id; b++ )
+        ;
+      if( b == CAN_TX_BUFFERS )
+        break;
+    }
+    if( i == canTxCount )
+      return;
+    
+    for( b = 0; canTxBufId[b] != CAN_TX_FREE; b++ )
+      ;
+    tx = &LPC21XX_CAN_C1TFI1 + 4 * b;  //TFI, TID, TDA, TDB of buffer b
+    tx[0] = ((CPU_INT32U)m->len << 16) | (m->rtr ? LPC21XX_CAN_RTR_MASK : 0);  //standard frame, PRIO 0
+    tx[1] = m->cob_id & 0x7FF;
+    tx[2] = m->data[0] | ((CPU_INT32U)m->data[1] << 8) | ((CPU_INT32U)m->data[2] << 16) | ((CPU_INT32U)m->data[3] << 24);
+    tx[3] = m->data[4] | ((CPU_INT32U)m->data[5] << 8) | ((CPU_INT32U)m->data[6] << 16) | ((CPU_INT32U)m->data[7] << 24);
+    LPC21XX_CAN_C1CMR = 0x01UL | (0x20UL << b);  //transmission request, select buffer b
+                                                 //no self reception request, see Errata ES_LPC2119/29 CAN.7
+    canTxBufId[b] = m->cob_id;
+    canTxBufQueued[b] = canTxQueue[i].queued;
+    if( canTxClass(m->cob_id) >= CAN_TX_CLASS_SDO )
+      usedSDO++;
+    used++;
+    
+    canTxCount--;
+    for( ; i < canTxCount; i++ )
+      canTxQueue[i] = canTxQueue[i + 1];
+  }
+  if( used > CAN_Transmit_BuffersMax )
+    CAN_Transmit_BuffersMax = used;
+}
+
 unsigned char canSend(CAN_PORT notused, Message *m)
 /******************************************************************************
-The driver sends a CAN message passed from the CANopen stack
+The driver sends a CAN message passed from the CANopen stack: the frame is 
+queued by priority and sent from the TX buffers (see canTxLoad).  If the queue
+is full the caller waits up to CAN_TX_WAIT_TICKS for space, after that the bus
+is considered stuck and is reset.
 INPUT	CAN_PORT is not used (only 1 avaiable)
 	Message *m pointer to message to send
-OUTPUT	1 if  hardware -> CAN frame
+OUTPUT	0 if queued, 1 if CAN is off, 3 if the bus was reset
 ******************************************************************************/
 {
-	CANFRM busFrame;
-        CPU_INT16S err;
+	UNS8 i;
+	UNS8 wait = CAN_TX_WAIT_TICKS;
+	OS_ERR err;
+	CPU_SR_ALLOC();
         
         if (!(PCONP & BIT13))  // check that CAN peripheral is active
           return 1;
         
-	busFrame.Identifier = m->cob_id & 0x1fffffff;
-	if( m->rtr != 0 )
+	CPU_CRITICAL_ENTER();
+	while( canTxCount >= CAN_TX_QUEUE_SIZE )
 	{
-		/* set rtr bit */
-		busFrame.Identifier |= 0x40000000 ;
+		CPU_CRITICAL_EXIT();
+		if( wait-- == 0 )  //nothing sent for CAN_TX_WAIT_TICKS (bus off, no other node on the bus)
+		{
+			canReset();
+			CAN_TX_ResetCounter++;
+			return 3;
+		}
+		CAN_Transmit_Waits++;
+		OSTimeDly(1, OS_OPT_TIME_DLY, &err);
+		CPU_CRITICAL_ENTER();
 	}
-	memcpy( busFrame.Data, m->data, m->len );
-	busFrame.DLC = m->len;
+	
+	/* behind the frames with the same or a lower COB-ID */
+	for( i = canTxCount; i > 0 && canTxQueue[i - 1].m.cob_id > m->cob_id; i-- )
+		canTxQueue[i] = canTxQueue[i - 1];
+	canTxQueue[i].m = *m;
+	canTxQueue[i].queued = GetTimer1Count();
+	canTxCount++;
+	if( canTxCount > CAN_Transmit_QueueMax )
+		CAN_Transmit_QueueMax = canTxCount;
+	
+	canTxLoad();
+	CPU_CRITICAL_EXIT();
+	
+	return 0;
+}
 
-	err = CanBusWrite(0,                                /* write it back to can bus layer          */
-         	 	(CPU_INT08U *)&busFrame,
-          	  	sizeof(CANFRM));
-        
-        if(err < 0)  //can TX semaphore timed out or other TX error (e.g. bad network connection)
-        {
-          CanBusIoCtl(0, CANBUS_FLUSH_TX, NULL); // reset the can TX semaphore
-          CanBusIoCtl(0, CANBUS_RESET, NULL);
-          CAN_TX_ResetCounter++;
-          return 3;
-        }
+UNS8 canTransmitISR(void)
+/******************************************************************************
+Called by the CAN 1 TX interrupt, after the interrupt was cleared: releases the
+TX buffers that were sent, records their queue to bus latency and loads the 
+next queued frames.
+OUTPUT	number of frames sent
+******************************************************************************/
+{
+	CPU_INT32U status = LPC21XX_CAN_C1SR;
+	CPU_INT32U latency;
+	UNS8 b, txClass, sent = 0;
+	CPU_SR_ALLOC();
+	
+	CPU_CRITICAL_ENTER();
+	for( b = 0; b < CAN_TX_BUFFERS; b++ )
+	{
+		if( canTxBufId[b] == CAN_TX_FREE || !(status & (0x04UL << (8 * b))) )  //TBS: buffer released
+			continue;
+		latency = (GetTimer1Count() - canTxBufQueued[b]) * 8;  //modulo arithmetic handles rollover
+		if( latency > 0xFFFF )
+			latency = 0xFFFF;
+		txClass = canTxClass(canTxBufId[b]);
+		if( latency > CAN_Transmit_MaxLatency[txClass] )
+			CAN_Transmit_MaxLatency[txClass] = (UNS16)latency;
+		canTxBufId[b] = CAN_TX_FREE;
+		sent++;
+	}
+	canTxLoad();
+	CPU_CRITICAL_EXIT();
 	
-    return 0;	//^^bug? 1;	// succesful
+	return sent;
+}
+
+void canReceiveISR(void)
+/******************************************************************************
+Called by the CAN 1 RX interrupt: copies the received frame from the CAN registers
+into the next free slot of the receive ring and wakes RunCANServerTask if the ring was
+empty (otherwise the task is still draining it and will find the frame).  The receive
+buffer is released by the caller.
+******************************************************************************/
+{
+	Message *m;
+	UNS32 frameStatus;
+	UNS32 word;
+	UNS8 wr = canRxWr;
+	OS_ERR err;
+	
+	if( (UNS8)(wr - canRxRd) >= CAN_RX_RING_SIZE )
+	{
+		CAN_Receive_Overruns++;  //frame lost
+		return;
+	}
+	frameStatus = LPC21XX_CAN_C1RFS;
+	if( ((frameStatus & LPC21XX_CAN_DLC_MASK) >> 16) > 8 )
+		return;  //illegal DLC
+	
+	m = &canRxRing[wr & (CAN_RX_RING_SIZE - 1)];
+	m->cob_id = (UNS16)LPC21XX_CAN_C1RID;
+	m->rtr = (frameStatus & LPC21XX_CAN_RTR_MASK) ? 1 : 0;
+	m->len = (UNS8)((frameStatus & LPC21XX_CAN_DLC_MASK) >> 16);
+	word = LPC21XX_CAN_C1RDA;
+	m->data[0] = (UNS8)word;
+	m->data[1] = (UNS8)(word >> 8);
+	m->data[2] = (UNS8)(word >> 16);
+	m->data[3] = (UNS8)(word >> 24);
+	word = LPC21XX_CAN_C1RDB;
+	m->data[4] = (UNS8)word;
+	m->data[5] = (UNS8)(word >> 8);
+	m->data[6] = (UNS8)(word >> 16);
+	m->data[7] = (UNS8)(word >> 24);
+	
+	canRxWr = wr + 1;  //publish the slot
+	if( wr == canRxRd )
+		OSSemPost(&CanRxSem, OS_OPT_POST_1, &err);
+}
+
+Message *canReceiveNext(void)
+/******************************************************************************
+Oldest frame of the receive ring, dispatched in place by the caller, which then 
+releases it with canReceiveDone.  Only called by RunCANServerTask.
+OUTPUT	NULL if the ring is empty
+******************************************************************************/
+{
+	UNS8 rd = canRxRd;
+	
+	if( rd == canRxWr )
+		return NULL;
+	return &canRxRing[rd & (CAN_RX_RING_SIZE - 1)];
+}
+
+void canReceiveDone(void)
+/******************************************************************************
+Releases the frame returned by canReceiveNext to the RX ISR
+******************************************************************************/
+{
+	canRxRd = canRxRd + 1;
 }
 
 unsigned char canReceive(Message *m)
 /******************************************************************************
-The driver passes a received CAN message to the stack
+The driver passes a received CAN message to the stack (copy of the oldest frame of 
+the receive ring, does not wait).  RunCANServerTask uses canReceiveNext instead.
 INPUT	Message *m pointer to received CAN message
 OUTPUT	1 if a message received
 ******************************************************************************/
 {
-        CANFRM 		busFrame;                                       /* Local: can frame                        */
-	CPU_INT16S	len;
-               
-                                                            	        /* blocking mode                           */
-        len = CanBusRead(0,                                 		/* read next can msg from can bus layer    */
-               		(CPU_INT08U *)&busFrame, 
-               		sizeof(CANFRM));            
+	Message *next = canReceiveNext();
 	
-	if( len > 0 )
-	{
-		m->cob_id 	= (UNS16) busFrame.Identifier ;
-		m->rtr		= (busFrame.Identifier & 0x40000000)?  1 : 0 ;
-		m->len		= busFrame.DLC ;
-		memcpy( m->data, busFrame.Data, busFrame.DLC );
-		return 1;
-	}
-	else //error
-        {
-              CanBusIoCtl(0, CANBUS_FLUSH_RX, NULL); // reset the can TX semaphore
-              CanBusIoCtl(0, CANBUS_RESET, NULL);
-              CAN_RX_ResetCounter++;
-          
-              return 0;
-        }
+	if( next == NULL )
+		return 0;
+	*m = *next;
+	canReceiveDone();
+	return 1;
 }
 
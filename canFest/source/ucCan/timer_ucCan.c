@@ -84,6 +84,16 @@ OUTPUT	value TIMEVAL (unsigned long) the elapsed time
  
 }
 
+TIMEVAL getCurrentTime(void)
+/******************************************************************************
+Return the free running timer the alarms are scheduled against.
+INPUT	void
+OUTPUT	value TIMEVAL (unsigned long) timer 1 count
+******************************************************************************/
+{
+  return GetTimer1Count();
+}
+
 
 void canOpenAlarm_interrupt(void)
 /******************************************************************************
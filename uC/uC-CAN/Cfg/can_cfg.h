@@ -80,10 +80,12 @@ extern "C" {
 												  
 #define  CANBUS_STAT_EN                         0u              /*  << Enable Bus Statistics                              */
 
-#define  CANBUS_TX_QSIZE                 (3u * CANBUS_N)        /*   << Transmit Queue Size in CAN Frames for each CAN Bus */
+#define  CANBUS_TX_QSIZE                 (2u * CANBUS_N)        /*   << Transmit Queue Size in CAN Frames for each CAN Bus */
  /* JML Note: TX_Q_SIZE should be 2 or more.  PM may sometimes send out a SYNC and SDO nearly simultaneously. Each Q adds 16bytes to RAM*/
-#define  CANBUS_RX_QSIZE                 (4u * CANBUS_N)        /*  << Receive Queue Size in CAN Frames for each CAN Bus  */
+/* Bus 0 frames no longer go through this queue: canSend queues them by priority (CAN_TX_QUEUE_SIZE in can_cpu.h) */
+#define  CANBUS_RX_QSIZE                 (1u * CANBUS_N)        /*  << Receive Queue Size in CAN Frames for each CAN Bus  */
 /* JML note: RX_Q_SIZE should be 3 or more (as high as possible).  PM may receive Heartbeats, PDOs, and SDOs nearly simultaneously.  Each Q adds 16bytes to RAM*/
+/* Bus 0 frames no longer go through this queue: the RX ISR fills the CanFestival receive ring (CAN_RX_RING_SIZE in can_cpu.h) */
 
 
 #define  CANBUS_HOOK_NS_EN                      1u              /*   Enable Node Status Handler Hook Function           */
@@ -180,7 +180,7 @@ void LPC21XXCANISR_Rx1 (void)
     }
     else
     {
-      CanBusRxHandler (LPC21XX_DevIds[0]);
+      canReceiveISR(); //straight into the CanFestival receive ring, see can_ucCan.c
       CAN_Receive_Messages++;
     }
     
@@ -227,10 +227,10 @@ void    LPC21XXCANISR_Tx1 (void)
 {
     volatile CPU_INT32U Interrupt_Status;
 
-    CanBusTxHandler (LPC21XX_DevIds[0]);
-    CAN_Transmit_Messages++;
-
-    Interrupt_Status = LPC21XX_CAN_C1ICR;             /* read ICR to clear interupt                */
+    Interrupt_Status = LPC21XX_CAN_C1ICR;             /* read ICR to clear interupt, before the    */
+                                                      /* buffers are checked: a buffer sent later  */
+                                                      /* raises the interrupt again                */
+    CAN_Transmit_Messages += canTransmitISR();        /* CanFestival priority TX queue, see can_ucCan.c */
     LPC21XX_CAN_VICVECTADDR = 0;                      /* acknowledge interrupt                     */
 }
 #endif
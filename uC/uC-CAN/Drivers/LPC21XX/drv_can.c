@@ -182,7 +182,8 @@ CPU_INT16S LPC21XXCANInit(CPU_INT32U arg)
         LPC21XX_CAN_VICVECTCTRL6 = 0x20 | 20;         /* Set channel and enable slot              */
         LPC21XX_CAN_VICINTSELECT &= ~0x00100000L;     /* Select IRQ category for this interrupt   */
 
-        LPC21XX_CAN_C1IER |= 0x02L;                   /* Enable Transmit Interrupt 1 on CAN device*/
+        LPC21XX_CAN_C1IER |= 0x0602L;                 /* Enable Transmit Interrupts 1, 2 and 3    */
+                                                      /* on CAN device (all TX buffers are used)  */
         LPC21XX_CAN_VICINTENABLE = 0x00100000L;       /* Enable CAN Tx1 Interrupt on VIC          */
 #endif
 
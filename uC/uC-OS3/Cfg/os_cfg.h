@@ -32,7 +32,7 @@
 #define OS_CFG_APP_HOOKS_EN                        1u           /* Enable (1) or Disable (0) application specific hooks                  */
 #define OS_CFG_ARG_CHK_EN                          0u           /* << Enable (1) or Disable (0) argument checking                           */
 #define OS_CFG_CALLED_FROM_ISR_CHK_EN              1u           /* Enable (1) or Disable (0) check for called from ISR                   */
-#define OS_CFG_DBG_EN                              1u           /* << Enable (1) or Disable (0) debug code/variables                        */
+#define OS_CFG_DBG_EN                              0u           /* << Enable (1) or Disable (0) debug code/variables                        */
 #define OS_CFG_TICK_EN                             1u           /* Enable (1) or Disable (0) the kernel tick                             */
 #define OS_CFG_DYN_TICK_EN                         0u           /* Enable (1) or Disable (0) the Dynamic Tick                            */
 #define OS_CFG_INVALID_OS_CALLS_CHK_EN             1u           /* Enable (1) or Disable (0) checks for invalid kernel calls             */
@@ -49,7 +49,7 @@
 
 
                                                                 /* --------------------------- EVENT FLAGS ----------------------------- */
-#define OS_CFG_FLAG_EN                             1u           /* Enable (1) or Disable (0) code generation for EVENT FLAGS             */
+#define OS_CFG_FLAG_EN                             0u           /* Enable (1) or Disable (0) code generation for EVENT FLAGS             */
 #define OS_CFG_FLAG_DEL_EN                         1u           /*     Include code for OSFlagDel()                                      */
 #define OS_CFG_FLAG_MODE_CLR_EN                    1u           /*     Include code for Wait on Clear EVENT FLAGS                        */
 #define OS_CFG_FLAG_PEND_ABORT_EN                  1u           /*     Include code for OSFlagPendAbort()                                */
@@ -66,7 +66,7 @@
 
 
                                                                 /* -------------------------- MESSAGE QUEUES --------------------------  */
-#define OS_CFG_Q_EN                                1u           /* Enable (1) or Disable (0) code generation for QUEUES                  */
+#define OS_CFG_Q_EN                                0u           /* Enable (1) or Disable (0) code generation for QUEUES                  */
 #define OS_CFG_Q_DEL_EN                            1u           /*     Include code for OSQDel()                                         */
 #define OS_CFG_Q_FLUSH_EN                          1u           /*     Include code for OSQFlush()                                       */
 #define OS_CFG_Q_PEND_ABORT_EN                     1u           /*     Include code for OSQPendAbort()                                   */
@@ -87,7 +87,7 @@
 #define OS_CFG_TASK_DEL_EN                         0u           /* << Include code for OSTaskDel()                                          */
 #define OS_CFG_TASK_IDLE_EN                        1u           /* Include the idle task                                                 */
 #define OS_CFG_TASK_PROFILE_EN                     0u           /* << Include variables in OS_TCB for profiling                             */
-#define OS_CFG_TASK_Q_EN                           1u           /* Include code for OSTaskQXXXX()                                        */
+#define OS_CFG_TASK_Q_EN                           0u           /* Include code for OSTaskQXXXX()                                        */
 #define OS_CFG_TASK_Q_PEND_ABORT_EN                0u           /* << Include code for OSTaskQPendAbort()                                   */
 #define OS_CFG_TASK_REG_TBL_SIZE                   1u           /* Number of task specific registers                                     */
 